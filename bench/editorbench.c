@@ -0,0 +1,392 @@
+/*
+* editorbench.c
+*
+* Microbenchmarks for the editor core: load, row insert / delete, typing,
+* editorUpdateRow, save, search and full frame rendering, each run over
+* synthetic corpora generated from a fixed seed (a huge C file, very long
+* lines, tab heavy code and UTF-8 heavy text) so numbers compare between
+* runs. Frames are rendered into the headless virtual screen.
+*
+* Results are written as JSON. With --compare, every result is checked
+* against a baseline written by an earlier run and anything slower by more
+* than the threshold is flagged (and the exit status is 1). Allocations
+* per operation are counted too, and some operations have a budget: a
+* cursor move (with its frame) must not allocate and a typed character
+* may allocate at most once. Going over a budget also fails the run.
+*
+* usage: editorbench [--scale N] [--reps N] [--out FILE]
+*                    [--compare BASELINE] [--threshold PCT]
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "editor.h"
+
+/** corpus **/
+
+static unsigned int benchSeed = 12345;
+
+static unsigned int benchRand() {
+  benchSeed = benchSeed * 1103515245u + 12345u;
+  return benchSeed >> 8;
+}
+
+static const char *benchWords[] = {
+  "int", "return", "if", "while", "row", "buf", "len", "editorUpdateRow",
+  "char", "static", "abAppend", "E", "cx", "render", "size", "memcpy",
+  "for", "struct", "hl", "filerow", "snprintf", "status", "void", "at"
+};
+
+#define BENCH_NWORDS (sizeof(benchWords) / sizeof(benchWords[0]))
+
+static const char *benchUnicode[] = {
+  "héllo", "wörld", "naïve", "日本語", "テキスト", "Ελληνικά", "кириллица",
+  "emoji 😀", "→", "∑", "ß", "编辑器", "café", "🚀🚀", "Ωmega"
+};
+
+#define BENCH_NUNICODE (sizeof(benchUnicode) / sizeof(benchUnicode[0]))
+
+// one line of the given corpus into buf, returns its length
+static int benchLine(const char *corpus, char *buf, int cap) {
+  int len = 0;
+  int words;
+  int w;
+
+  if(strcmp(corpus, "huge") == 0) {
+    len += snprintf(&buf[len], cap - len, "%*s", (int) (benchRand() % 4) * 2, "");
+    words = 3 + benchRand() % 8;
+    for(w = 0; w < words; w++) {
+      len += snprintf(&buf[len], cap - len, "%s%s", benchWords[benchRand() % BENCH_NWORDS],
+        benchRand() % 3 ? " " : "(");
+    }
+    len += snprintf(&buf[len], cap - len, benchRand() % 8 ? ";" : "// note");
+  } else if(strcmp(corpus, "longlines") == 0) {
+    while(len < cap - 64) {
+      len += snprintf(&buf[len], cap - len, "%s ", benchWords[benchRand() % BENCH_NWORDS]);
+    }
+  } else if(strcmp(corpus, "tabs") == 0) {
+    len += snprintf(&buf[len], cap - len, "%.*s", (int) (benchRand() % 6), "\t\t\t\t\t\t");
+    words = 2 + benchRand() % 6;
+    for(w = 0; w < words; w++) {
+      len += snprintf(&buf[len], cap - len, "%s\t", benchWords[benchRand() % BENCH_NWORDS]);
+    }
+  } else {
+    words = 4 + benchRand() % 10;
+    for(w = 0; w < words; w++) {
+      len += snprintf(&buf[len], cap - len, "%s ", benchUnicode[benchRand() % BENCH_NUNICODE]);
+    }
+  }
+
+  return len < cap ? len : cap - 1;
+}
+
+// write a corpus to a temp file, returns its (malloc'd) path
+static char *benchCorpus(const char *corpus, const char *ext, int lines, int linecap) {
+  char *path = malloc(64);
+  snprintf(path, 64, "/tmp/conchpad-bench-XXXXXX%s", ext);
+  int fd = mkstemps(path, strlen(ext));
+  if(fd == -1) {
+    perror("mkstemps");
+    exit(1);
+  }
+
+  // restart the sequence so a corpus doesn't depend on how many random
+  // numbers the runs before it (--reps, warm-up, rendering) used
+  benchSeed = 12345;
+  FILE *fp = fdopen(fd, "w");
+  char *line = malloc(linecap);
+  int j;
+  for(j = 0; j < lines; j++) {
+    int len = benchLine(corpus, line, linecap);
+    fwrite(line, 1, len, fp);
+    fputc('\n', fp);
+  }
+  free(line);
+  fclose(fp);
+  return path;
+}
+
+/** results **/
+
+struct benchResult {
+  char name[64];
+  double ns_per_op;
+  double allocs_per_op;
+  long ops;
+};
+
+static struct benchResult benchResults[128];
+static int benchCount = 0;
+static int benchReps = 3;
+static int benchOverBudget = 0;
+
+// best of benchReps runs of fn, which performs ops operations per run.
+// An untimed warm-up run goes first so caches have grown whatever
+// --reps is, and allocations are taken from the last timed run; more than
+// maxallocs per op (unless maxallocs is negative) fails the run
+static void benchRun(const char *corpus, const char *op, long ops, void (*fn)(long),
+    double maxallocs) {
+  double best = -1;
+  double allocs = 0;
+  int r;
+  fn(ops);
+  for(r = 0; r < benchReps; r++) {
+    long long before = allocCount();
+    long long start = editorNow();
+    fn(ops);
+    double ns = (double) (editorNow() - start) / ops;
+    allocs = (double) (allocCount() - before) / ops;
+    if(best < 0 || ns < best) {
+      best = ns;
+    }
+  }
+
+  struct benchResult *res = &benchResults[benchCount++];
+  snprintf(res->name, sizeof(res->name), "%s/%s", corpus, op);
+  res->ns_per_op = best;
+  res->allocs_per_op = allocs;
+  res->ops = ops;
+  fprintf(stderr, "%-24s %14.1f ns/op %10.3f allocs/op  (%ld ops)\n", res->name, best, allocs, ops);
+
+  if(maxallocs >= 0 && allocs > maxallocs) {
+    fprintf(stderr, "%s: %.3f allocations per op, budget is %.0f\n", res->name, allocs, maxallocs);
+    benchOverBudget = 1;
+  }
+}
+
+/** benchmarks **/
+
+static char *benchPath;
+
+static void benchLoad(long ops) {
+  long j;
+  for(j = 0; j < ops; j++) {
+    editorCloseFile();
+    editorOpen(benchPath);
+  }
+}
+
+static void benchRowInsertDelete(long ops) {
+  int mid = E.numrows / 2;
+  long j;
+  for(j = 0; j < ops / 2; j++) {
+    editorInsertRow(mid, "inserted row", 12);
+  }
+  for(j = 0; j < ops / 2; j++) {
+    editorDelRow(mid);
+  }
+}
+
+static void benchTyping(long ops) {
+  E.cy = E.numrows / 2;
+  E.cx = E.row[E.cy].size / 2;
+  long j;
+  for(j = 0; j < ops / 2; j++) {
+    editorInsertChar('a' + j % 26);
+  }
+  for(j = 0; j < ops / 2; j++) {
+    editorDelChar();
+  }
+}
+
+static void benchUpdateRow(long ops) {
+  long j;
+  for(j = 0; j < ops; j++) {
+    editorUpdateRow(&E.row[j % E.numrows]);
+  }
+}
+
+static void benchSave(long ops) {
+  long j;
+  for(j = 0; j < ops; j++) {
+    editorSave();
+  }
+}
+
+static void benchSearch(long ops) {
+  long j;
+  int col;
+  for(j = 0; j < ops; j++) {
+    // a miss scans every row
+    if(editorFindRow("no such needle", 0, 1, &col) != -1) {
+      fprintf(stderr, "editorbench: search found a needle that isn't there\n");
+      exit(1);
+    }
+  }
+}
+
+// cursor moves that stay on screen, each followed by its frame
+static void benchCursorMove(long ops) {
+  E.cy = E.rowoff;
+  E.cx = 0;
+  editorScreenRefresh();
+  long j;
+  for(j = 0; j < ops; j++) {
+    editorCursorMove(j / 10 % 2 ? ARROW_UP : ARROW_DOWN);
+    editorScreenRefresh();
+  }
+}
+
+static void benchRender(long ops) {
+  long j;
+  for(j = 0; j < ops; j++) {
+    E.cy = benchRand() % E.numrows;
+    E.cx = 0;
+    editorScreenRefresh();
+  }
+}
+
+static void benchCorpusSuite(const char *corpus, const char *ext, int lines, int linecap) {
+  benchPath = benchCorpus(corpus, ext, lines, linecap);
+
+  benchRun(corpus, "load", 1, benchLoad, -1);
+  benchRun(corpus, "row_insert_delete", 2000, benchRowInsertDelete, -1);
+  benchRun(corpus, "typing", 10000, benchTyping, 1);
+  benchRun(corpus, "update_row", E.numrows < 20000 ? E.numrows : 20000, benchUpdateRow, -1);
+  benchRun(corpus, "save", 1, benchSave, -1);
+  benchRun(corpus, "search", 5, benchSearch, -1);
+  benchRun(corpus, "cursor_move", 1000, benchCursorMove, 0);
+  benchRun(corpus, "render", 200, benchRender, -1);
+
+  editorCloseFile();
+  unlink(benchPath);
+  free(benchPath);
+}
+
+/** output **/
+
+static void benchWriteJson(FILE *fp, int scale) {
+  fprintf(fp, "{\n  \"scale\": %d,\n  \"reps\": %d,\n  \"results\": [\n", scale, benchReps);
+  int j;
+  for(j = 0; j < benchCount; j++) {
+    fprintf(fp, "    {\"name\": \"%s\", \"ns_per_op\": %.1f, \"allocs_per_op\": %.3f, \"ops\": %ld}%s\n",
+      benchResults[j].name, benchResults[j].ns_per_op, benchResults[j].allocs_per_op, benchResults[j].ops,
+      j + 1 < benchCount ? "," : "");
+  }
+  fprintf(fp, "  ]\n}\n");
+}
+
+// ns_per_op recorded for name in a baseline file, -1 if missing
+static double benchBaseline(const char *json, const char *name) {
+  char key[96];
+  snprintf(key, sizeof(key), "\"name\": \"%.63s\"", name);
+  const char *p = strstr(json, key);
+  if(p == NULL || (p = strstr(p, "\"ns_per_op\":")) == NULL) {
+    return -1;
+  }
+  return atof(p + strlen("\"ns_per_op\":"));
+}
+
+static int benchCompare(const char *path, double threshold) {
+  FILE *fp = fopen(path, "r");
+  if(fp == NULL) {
+    perror(path);
+    return 1;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  rewind(fp);
+  char *json = malloc(size + 1);
+  json[fread(json, 1, size, fp)] = '\0';
+  fclose(fp);
+
+  int regressions = 0;
+  printf("%-24s %12s %12s %8s\n", "benchmark", "baseline", "current", "change");
+  int j;
+  for(j = 0; j < benchCount; j++) {
+    double base = benchBaseline(json, benchResults[j].name);
+    double cur = benchResults[j].ns_per_op;
+    if(base <= 0) {
+      printf("%-24s %12s %12.1f %8s\n", benchResults[j].name, "-", cur, "new");
+      continue;
+    }
+
+    double change = (cur - base) / base * 100.0;
+    int regressed = change > threshold;
+    regressions += regressed;
+    printf("%-24s %12.1f %12.1f %+7.1f%%%s\n", benchResults[j].name, base, cur, change,
+      regressed ? "  REGRESSION" : "");
+  }
+
+  free(json);
+  if(regressions) {
+    printf("%d benchmark(s) regressed by more than %.0f%%\n", regressions, threshold);
+  }
+  return regressions ? 1 : 0;
+}
+
+/** main **/
+
+int main(int argc, char *argv[]) {
+  int scale = 1;
+  char *out = NULL;
+  char *baseline = NULL;
+  double threshold = 10.0;
+
+  int i;
+  for(i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+      scale = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      benchReps = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out = argv[++i];
+    } else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+      baseline = argv[++i];
+    } else if(strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: editorbench [--scale N] [--reps N] [--out FILE] "
+        "[--compare BASELINE] [--threshold PCT]\n");
+      return 2;
+    }
+  }
+  if(scale < 1) {
+    scale = 1;
+  }
+  if(benchReps < 1) {
+    benchReps = 1;
+  }
+
+  // render into the virtual screen instead of a terminal
+  E.headless.active = 1;
+  if(vscreenInit(&E.headless.screen, 50, 160) == -1) {
+    return 1;
+  }
+  initEditor();
+
+  benchCorpusSuite("huge", ".c", 200000 * scale, 160);
+  benchCorpusSuite("longlines", ".txt", 500 * scale, 16384);
+  benchCorpusSuite("tabs", ".c", 100000 * scale, 160);
+  benchCorpusSuite("unicode", ".txt", 100000 * scale, 320);
+
+  if(out) {
+    FILE *fp = fopen(out, "w");
+    if(fp == NULL) {
+      perror(out);
+      return 1;
+    }
+    benchWriteJson(fp, scale);
+    fclose(fp);
+  } else {
+    benchWriteJson(stdout, scale);
+  }
+
+  int status = baseline ? benchCompare(baseline, threshold) : 0;
+  if(benchOverBudget) {
+    fprintf(stderr, "editorbench: allocation budget exceeded\n");
+    status = 1;
+  }
+  return status;
+}
@@ -0,0 +1,197 @@
+/*
+* kwbench.c
+*
+* Highlighting throughput benchmark for keyword lookup: the generated
+* perfect hash tables against the linear strncmp scan they replaced, and
+* the hand written C lexer against the DFA compiled from syntax/c.grammar.
+* The corpus is synthetic C generated from a fixed seed so runs compare.
+*
+* usage: kwbench [megabytes]
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "keywords.h"
+#include "syntax.h"
+#include "grammar.h"
+
+/** corpus **/
+
+static uint32_t benchSeed = 12345;
+
+static uint32_t benchRand() {
+  benchSeed = benchSeed * 1103515245u + 12345u;
+  return benchSeed >> 8;
+}
+
+static const char *benchIdents[] = {
+  "row", "buf", "len", "editorUpdateRow", "i", "j", "abAppend", "E", "cx",
+  "render", "size", "memcpy", "hl", "filerow", "snprintf", "status", "at"
+};
+
+// roughly C shaped lines: mostly identifiers and keywords with some
+// punctuation, numbers and the occasional comment
+static char *benchCorpus(size_t target, size_t *outlen, int *nlines) {
+  char *buf = malloc(target + 256);
+  size_t len = 0;
+  *nlines = 0;
+
+  while(len < target) {
+    int words = 3 + benchRand() % 8;
+    int indent = (benchRand() % 4) * 2;
+    memset(&buf[len], ' ', indent);
+    len += indent;
+
+    int w;
+    for(w = 0; w < words; w++) {
+      const char *word;
+      int r = benchRand() % 10;
+      if(r < 4) {
+        word = kw_c.slots[benchRand() % kw_c.nslots].word;
+      } else if(r < 9) {
+        word = benchIdents[benchRand() % (sizeof(benchIdents) / sizeof(benchIdents[0]))];
+      } else {
+        word = "42";
+      }
+      len += sprintf(&buf[len], "%s%s", word, (benchRand() % 3) ? " " : "(");
+    }
+    if(benchRand() % 8 == 0) {
+      len += sprintf(&buf[len], "// trailing comment");
+    } else {
+      buf[len++] = ';';
+    }
+    buf[len++] = '\n';
+    (*nlines)++;
+  }
+
+  *outlen = len;
+  return buf;
+}
+
+/** benchmark **/
+
+static double benchNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int benchSeparator(int c) {
+  return isspace(c) || c == '\0' || strchr(",.()+-/*=~%<>[];{}", c) != NULL;
+}
+
+// tokenize the corpus the way the highlighter does and classify every
+// word with the given lookup. Returns the number of keywords found
+static long benchLookups(const char *buf, size_t len,
+    int (*lookup)(const struct kwTable *, const char *, int), long *words) {
+  long found = 0;
+  size_t i = 0;
+  *words = 0;
+
+  while(i < len) {
+    if(benchSeparator(buf[i])) {
+      i++;
+      continue;
+    }
+    size_t end = i;
+    while(end < len && !benchSeparator(buf[end])) {
+      end++;
+    }
+    if(lookup(&kw_c, &buf[i], end - i) != KW_NONE) {
+      found++;
+    }
+    (*words)++;
+    i = end;
+  }
+
+  return found;
+}
+
+static void benchHighlight(struct editorSyntax *syntax, const char *corpus,
+    size_t len, unsigned char *hl) {
+  int state = SYN_STATE_NORMAL;
+  size_t start = 0;
+  while(start < len) {
+    const char *nl = memchr(&corpus[start], '\n', len - start);
+    size_t end = nl ? (size_t)(nl - corpus) : len;
+    state = syntaxHighlight(syntax, &corpus[start], end - start, &hl[start], state);
+    start = end + 1;
+  }
+}
+
+static int benchPerfect(const struct kwTable *t, const char *s, int len) {
+  return kwLookup(t, s, len);
+}
+
+int main(int argc, char *argv[]) {
+  size_t megabytes = argc > 1 ? (size_t) atoi(argv[1]) : 32;
+  size_t len;
+  int nlines;
+  char *corpus = benchCorpus(megabytes << 20, &len, &nlines);
+
+  // both lookups must agree on every keyword before anything is timed
+  uint32_t j;
+  for(j = 0; j < kw_c.nslots; j++) {
+    const struct kwSlot *s = &kw_c.slots[j];
+    if(kwLookup(&kw_c, s->word, s->len) != s->type ||
+        kwLookupLinear(&kw_c, s->word, s->len) != s->type) {
+      fprintf(stderr, "kwbench: lookup mismatch for %s\n", s->word);
+      return 1;
+    }
+  }
+
+  long words;
+  double t0 = benchNow();
+  long naive = benchLookups(corpus, len, kwLookupLinear, &words);
+  double t1 = benchNow();
+  long perfect = benchLookups(corpus, len, benchPerfect, &words);
+  double t2 = benchNow();
+
+  if(naive != perfect) {
+    fprintf(stderr, "kwbench: naive found %ld keywords, perfect hash %ld\n", naive, perfect);
+    return 1;
+  }
+
+  // whole row highlighting, which is what the user actually waits on
+  struct editorSyntax *builtin = syntaxSelect("bench.c");
+  unsigned char *hl = malloc(len);
+  double t3 = benchNow();
+  benchHighlight(builtin, corpus, len, hl);
+  double t4 = benchNow();
+
+  struct grammar *g = grammarLoadFile("syntax/c.grammar", 0);
+  double t5 = 0;
+  double t6 = 0;
+  if(g) {
+    t5 = benchNow();
+    benchHighlight(&g->syntax, corpus, len, hl);
+    t6 = benchNow();
+  }
+
+  double mb = len / (1024.0 * 1024.0);
+  printf("corpus: %.1f MB, %d lines, %ld words, %ld keywords\n", mb, nlines, words, perfect);
+  printf("linear scan:  %8.1f MB/s  %6.1f ns/word\n", mb / (t1 - t0), (t1 - t0) * 1e9 / words);
+  printf("perfect hash: %8.1f MB/s  %6.1f ns/word  (%.1fx)\n", mb / (t2 - t1),
+    (t2 - t1) * 1e9 / words, (t1 - t0) / (t2 - t1));
+  printf("hand written lexer: %8.1f MB/s\n", mb / (t4 - t3));
+  if(g) {
+    printf("grammar DFA lexer:  %8.1f MB/s  (%.2fx)\n", mb / (t6 - t5), (t4 - t3) / (t6 - t5));
+  } else {
+    printf("grammar DFA lexer:  syntax/c.grammar not found\n");
+  }
+
+  free(hl);
+  free(corpus);
+  return 0;
+}
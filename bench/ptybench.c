@@ -0,0 +1,404 @@
+/*
+* ptybench.c
+*
+* End-to-end benchmark of the real ConchPad binary. The editor runs in a
+* pseudo-terminal of the given size, so raw mode, editorReadKey and the
+* frame writes all take their real paths. Keys from a key script are sent
+* one at a time with human-like gaps, everything the editor writes is fed
+* through the virtual screen, and each key is timed from the moment it is
+* written until the frame it caused has fully arrived.
+*
+* --baud throttles how fast output is read back, like a serial or remote
+* link: the pty fills up and the editor's writes block, as they would.
+*
+* Each key produces one frame (the main loop and prompts repaint once per
+* key), but background work also repaints between keys. So frames are
+* matched to keys in order, and a frame only counts for a key that was
+* written before the frame's first byte arrived. Frames that began
+* arriving before the oldest outstanding key was sent, or with no key
+* outstanding, are background repaints. They are counted separately.
+*
+* usage: ptybench --script KEYS [--bin PATH] [--size COLSxROWS] [--baud BPS]
+*                 [--delay MS] [--jitter MS] [--timeout MS] [--expect SCREEN]
+*                 [--dump-screen] [file]
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _DEFAULT_SOURCE
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hdrhist.h"
+#include "keyscript.h"
+#include "vscreen.h"
+
+#define PTY_MAX_PENDING 1024 // keys sent but not yet painted
+
+/** data **/
+
+// "cursor on" ends every frame the editor draws
+static const char ptyFrameEnd[] = "\x1b[?25h";
+
+struct ptyRun {
+  int fd; // pty master
+  pid_t pid;
+  vscreen screen;
+  long long baud; // 0 for unthrottled reads
+  double tokens; // bytes the simulated link may deliver right now
+  long long refill_ns; // when tokens were last topped up
+
+  int matched; // bytes of ptyFrameEnd matched so far
+  long long frame_bytes; // bytes of the frame being received
+  long long frame_start_ns; // when its first byte arrived
+  long long pending[PTY_MAX_PENDING]; // send time of keys awaiting a frame
+  int head;
+  int tail;
+
+  long long keys;
+  long long frames;
+  long long extra_frames;
+  long long bytes;
+  long long timeouts;
+  long long last_output_ns;
+  hdrHist latency;
+  hdrHist frame_size;
+};
+
+static unsigned int ptySeed = 12345;
+
+/** helpers **/
+
+static unsigned int ptyRand() {
+  ptySeed = ptySeed * 1103515245u + 12345u;
+  return ptySeed >> 8;
+}
+
+static long long ptyNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// account for output bytes and close frames as their end marker arrives
+static void ptyScan(struct ptyRun *run, const char *buf, int len, long long now) {
+  int j;
+  for(j = 0; j < len; j++) {
+    if(run->frame_bytes++ == 0) {
+      run->frame_start_ns = now;
+    }
+    if(buf[j] == ptyFrameEnd[run->matched]) {
+      run->matched++;
+    } else {
+      run->matched = buf[j] == ptyFrameEnd[0];
+    }
+    if(run->matched < (int) sizeof(ptyFrameEnd) - 1) {
+      continue;
+    }
+
+    run->matched = 0;
+    run->frames++;
+    hdrRecord(&run->frame_size, run->frame_bytes);
+    run->frame_bytes = 0;
+    if(run->head != run->tail && run->pending[run->head] <= run->frame_start_ns) {
+      hdrRecord(&run->latency, now - run->pending[run->head]);
+      run->head = (run->head + 1) % PTY_MAX_PENDING;
+    } else {
+      run->extra_frames++;
+    }
+  }
+}
+
+// read output until the deadline, no faster than the link allows.
+// Returns -1 once the editor has gone away
+static int ptyPump(struct ptyRun *run, long long deadline) {
+  char buf[65536];
+
+  while(1) {
+    long long now = ptyNow();
+    if(now >= deadline) {
+      return 0;
+    }
+
+    size_t want = sizeof(buf);
+    int wait_ms = (deadline - now + 999999) / 1000000;
+    if(run->baud) {
+      // 8N1: ten bits on the wire per byte
+      run->tokens += (now - run->refill_ns) / 1e9 * run->baud / 10.0;
+      run->refill_ns = now;
+      if(run->tokens > sizeof(buf)) {
+        run->tokens = sizeof(buf);
+      }
+      if(run->tokens < 1) {
+        int refill_ms = (1 - run->tokens) * 10000.0 / run->baud + 1;
+        wait_ms = refill_ms < wait_ms ? refill_ms : wait_ms;
+        usleep(wait_ms * 1000);
+        continue;
+      }
+      want = run->tokens;
+    }
+
+    struct pollfd pfd = { run->fd, POLLIN, 0 };
+    int ready = poll(&pfd, 1, wait_ms);
+    if(ready < 0 && errno != EINTR) {
+      return -1;
+    }
+    if(ready <= 0) {
+      continue;
+    }
+
+    int n = read(run->fd, buf, want);
+    if(n <= 0) {
+      return -1;
+    }
+    now = ptyNow();
+    run->tokens -= run->baud ? n : 0;
+    run->bytes += n;
+    run->last_output_ns = now;
+    vscreenWrite(&run->screen, buf, n);
+    ptyScan(run, buf, n, now);
+  }
+}
+
+// pump until nothing has been written for quiet_ms (or limit_ms passes)
+static int ptySettle(struct ptyRun *run, int quiet_ms, int limit_ms) {
+  long long limit = ptyNow() + limit_ms * 1000000LL;
+  run->last_output_ns = ptyNow();
+  while(ptyNow() < limit) {
+    if(ptyPump(run, ptyNow() + quiet_ms * 1000000LL / 4) == -1) {
+      return -1;
+    }
+    if(ptyNow() - run->last_output_ns >= quiet_ms * 1000000LL) {
+      return 0;
+    }
+  }
+  return 0;
+}
+
+// the oldest outstanding key has waited timeout_ms with no output at all
+static int ptyStalled(struct ptyRun *run, int timeout_ms) {
+  long long since = run->pending[run->head] > run->last_output_ns ?
+    run->pending[run->head] : run->last_output_ns;
+  return ptyNow() - since > timeout_ms * 1000000LL;
+}
+
+static pid_t ptySpawn(const char *bin, const char *file, int rows, int cols, int *fd) {
+  struct winsize ws = { rows, cols, 0, 0 };
+  pid_t pid = forkpty(fd, NULL, NULL, &ws);
+  if(pid == 0) {
+    setenv("TERM", "xterm", 1);
+    if(file) {
+      execl(bin, bin, file, (char *) NULL);
+    } else {
+      execl(bin, bin, (char *) NULL);
+    }
+    _exit(127);
+  }
+  return pid;
+}
+
+// compare the final screen with an expected one (one row per line).
+// Returns the number of rows that differ
+static int ptyCompare(struct ptyRun *run, const char *path) {
+  FILE *fp = fopen(path, "r");
+  if(fp == NULL) {
+    perror(path);
+    return -1;
+  }
+
+  char *got = malloc(run->screen.cols + 1);
+  char *line = NULL;
+  size_t linecap = 0;
+  int diffs = 0;
+  int y;
+  for(y = 0; y < run->screen.rows; y++) {
+    ssize_t len = getline(&line, &linecap, fp);
+    if(len < 0) {
+      len = 0;
+    }
+    while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == ' ')) {
+      len--;
+    }
+
+    vscreenRow(&run->screen, y, got);
+    if((size_t) len != strlen(got) || memcmp(line, got, len) != 0) {
+      fprintf(stderr, "row %d differs\n  want: %.*s\n  got:  %s\n", y + 1, (int) len, line, got);
+      diffs++;
+    }
+  }
+
+  free(line);
+  free(got);
+  fclose(fp);
+  return diffs;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: ptybench --script KEYS [--bin PATH] [--size COLSxROWS] [--baud BPS]\n"
+    "                [--delay MS] [--jitter MS] [--timeout MS] [--expect SCREEN]\n"
+    "                [--dump-screen] [file]\n");
+  exit(2);
+}
+
+/** main **/
+
+int main(int argc, char *argv[]) {
+  const char *bin = "./ConchPad";
+  const char *script = NULL;
+  const char *expect = NULL;
+  const char *file = NULL;
+  int rows = 24;
+  int cols = 80;
+  int delay_ms = 80;
+  int jitter_ms = 40;
+  int timeout_ms = 2000;
+  int dump = 0;
+  struct ptyRun run;
+  memset(&run, 0, sizeof(run));
+
+  int i;
+  for(i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--bin") == 0 && i + 1 < argc) {
+      bin = argv[++i];
+    } else if(strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+      script = argv[++i];
+    } else if(strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if(sscanf(argv[++i], "%dx%d", &cols, &rows) != 2 || cols < 1 || rows < 3) {
+        usage();
+      }
+    } else if(strcmp(argv[i], "--baud") == 0 && i + 1 < argc) {
+      run.baud = atoll(argv[++i]);
+    } else if(strcmp(argv[i], "--delay") == 0 && i + 1 < argc) {
+      delay_ms = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+      jitter_ms = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+      timeout_ms = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--expect") == 0 && i + 1 < argc) {
+      expect = argv[++i];
+    } else if(strcmp(argv[i], "--dump-screen") == 0) {
+      dump = 1;
+    } else if(argv[i][0] == '-' && argv[i][1] == '-') {
+      usage();
+    } else {
+      file = argv[i];
+    }
+  }
+  if(script == NULL) {
+    usage();
+  }
+
+  char *keys;
+  size_t keyslen;
+  char err[128];
+  if(keyScriptLoad(script, &keys, &keyslen, err, sizeof(err)) == -1) {
+    fprintf(stderr, "%s\n", err);
+    return 2;
+  }
+  if(vscreenInit(&run.screen, rows, cols) == -1) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  hdrInit(&run.latency);
+  hdrInit(&run.frame_size);
+
+  signal(SIGPIPE, SIG_IGN);
+  run.pid = ptySpawn(bin, file, rows, cols, &run.fd);
+  if(run.pid < 0) {
+    perror("forkpty");
+    return 1;
+  }
+
+  // let the editor load and paint (and finish any background repaints)
+  long long start = ptyNow();
+  run.refill_ns = start;
+  if(ptySettle(&run, 300, 30000) == -1) {
+    fprintf(stderr, "ptybench: %s exited during startup\n", bin);
+    return 1;
+  }
+  long long ready = ptyNow();
+  run.frames = 0;
+  run.extra_frames = 0;
+  run.bytes = 0;
+  hdrInit(&run.frame_size);
+
+  size_t pos = 0;
+  int gone = 0;
+  while(pos < keyslen && !gone) {
+    int gap = delay_ms + (jitter_ms ? (int) (ptyRand() % (2 * jitter_ms + 1)) - jitter_ms : 0);
+    if(ptyPump(&run, ptyNow() + (gap > 0 ? gap : 0) * 1000000LL) == -1) {
+      gone = 1;
+      break;
+    }
+
+    // give up on keys that never got a frame, unless output is still
+    // arriving (a slow link can be seconds behind)
+    while(run.head != run.tail && ptyStalled(&run, timeout_ms)) {
+      run.head = (run.head + 1) % PTY_MAX_PENDING;
+      run.timeouts++;
+    }
+    if((run.tail + 1) % PTY_MAX_PENDING == run.head) {
+      continue;
+    }
+
+    size_t n = keyScriptNext(&keys[pos], keyslen - pos);
+    if(write(run.fd, &keys[pos], n) != (ssize_t) n) {
+      gone = 1;
+      break;
+    }
+    run.pending[run.tail] = ptyNow();
+    run.tail = (run.tail + 1) % PTY_MAX_PENDING;
+    run.keys++;
+    pos += n;
+  }
+
+  // wait out the last frames
+  while(!gone && run.head != run.tail && !ptyStalled(&run, timeout_ms)) {
+    gone = ptyPump(&run, ptyNow() + 10000000LL) == -1;
+  }
+  run.timeouts += (run.tail - run.head + PTY_MAX_PENDING) % PTY_MAX_PENDING;
+  if(!gone) {
+    ptySettle(&run, 200, timeout_ms);
+  }
+  long long finished = ptyNow();
+
+  kill(run.pid, SIGKILL);
+  waitpid(run.pid, NULL, 0);
+
+  int diffs = expect ? ptyCompare(&run, expect) : 0;
+
+  printf("{\n");
+  printf("  \"size\": \"%dx%d\",\n  \"baud\": %lld,\n", cols, rows, run.baud);
+  printf("  \"startup_ms\": %.1f,\n  \"run_ms\": %.1f,\n", (ready - start) / 1e6, (finished - ready) / 1e6);
+  printf("  \"keys\": %lld,\n  \"frames\": %lld,\n  \"extra_frames\": %lld,\n  \"timeouts\": %lld,\n",
+    run.keys, run.frames, run.extra_frames, run.timeouts);
+  printf("  \"bytes\": %lld,\n", run.bytes);
+  printf("  \"key_to_frame_us\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f},\n",
+    hdrPercentile(&run.latency, 50) / 1e3, hdrPercentile(&run.latency, 90) / 1e3,
+    hdrPercentile(&run.latency, 99) / 1e3, hdrPercentile(&run.latency, 100) / 1e3);
+  printf("  \"frame_bytes\": {\"p50\": %lld, \"p99\": %lld, \"max\": %lld},\n",
+    hdrPercentile(&run.frame_size, 50), hdrPercentile(&run.frame_size, 99),
+    hdrPercentile(&run.frame_size, 100));
+  printf("  \"exited_early\": %s,\n", gone ? "true" : "false");
+  printf("  \"screen_matches\": %s\n}\n", expect == NULL ? "null" : diffs == 0 ? "true" : "false");
+
+  if(dump) {
+    printf("--- screen ---\n");
+    vscreenDump(&run.screen, stdout);
+  }
+
+  return gone || run.timeouts || diffs ? 1 : 0;
+}
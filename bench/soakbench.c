@@ -0,0 +1,347 @@
+/*
+* soakbench.c
+*
+* Long running soak test. Drives the editor headlessly through hours of
+* simulated editing on a large file (typing, pastes, deleted ranges,
+* navigation, searches, folds and saves, all through the real key
+* handling and prompts) and samples RSS, heap statistics and key latency
+* percentiles along the way. The buffer is steered to stay near its
+* starting size, so memory should level off once caches have warmed up.
+*
+* Two things fail the run:
+*   - leaks: after closing the file the heap must be back where it was
+*     after an open / close of the same file before the soak
+*   - growth: RSS at the end more than --growth percent above RSS once
+*     the first tenth of the run has warmed things up (fragmentation or
+*     unbounded caches)
+*
+* usage: soakbench [--hours H] [--lines N] [--sample N] [--seconds S]
+*                  [--seed N] [--leak-kb KB] [--growth PCT] [--csv FILE]
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _DEFAULT_SOURCE
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "editor.h"
+
+#define SOAK_ACTIONS_PER_HOUR 1800 // one edit, search, jump or save every two seconds
+
+/** helpers **/
+
+static unsigned int soakSeed = 12345;
+
+static unsigned int soakRand() {
+  soakSeed = soakSeed * 1103515245u + 12345u;
+  return soakSeed >> 8;
+}
+
+static const char *soakWords[] = {
+  "int", "return", "if", "while", "row", "buf", "len", "editorUpdateRow",
+  "char", "static", "abAppend", "E", "cx", "render", "size", "memcpy",
+  "for", "struct", "hl", "filerow", "snprintf", "status", "void", "at"
+};
+
+#define SOAK_NWORDS (sizeof(soakWords) / sizeof(soakWords[0]))
+
+struct soakKeys {
+  char *b;
+  size_t len;
+  size_t cap;
+};
+
+static void soakAppend(struct soakKeys *k, const char *s, size_t n) {
+  if(k->len + n > k->cap) {
+    k->cap = k->cap ? k->cap * 2 : 4096;
+    while(k->cap < k->len + n) {
+      k->cap *= 2;
+    }
+    k->b = realloc(k->b, k->cap);
+    if(k->b == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  memcpy(&k->b[k->len], s, n);
+  k->len += n;
+}
+
+static void soakAppendStr(struct soakKeys *k, const char *s) {
+  soakAppend(k, s, strlen(s));
+}
+
+static void soakRepeat(struct soakKeys *k, const char *s, int n) {
+  while(n-- > 0) {
+    soakAppendStr(k, s);
+  }
+}
+
+// words separated by spaces, about len bytes
+static void soakWordsOf(struct soakKeys *k, int len) {
+  int n = 0;
+  while(n < len) {
+    const char *w = soakWords[soakRand() % SOAK_NWORDS];
+    soakAppendStr(k, w);
+    soakAppendStr(k, " ");
+    n += strlen(w) + 1;
+  }
+}
+
+static long long soakBufferBytes() {
+  long long bytes = 0;
+  int j;
+  for(j = 0; j < E.numrows; j++) {
+    bytes += E.row[j].size + 1;
+  }
+  return bytes;
+}
+
+static long soakRssKb() {
+  long pages = 0;
+  long resident = 0;
+  FILE *fp = fopen("/proc/self/statm", "r");
+  if(fp) {
+    if(fscanf(fp, "%ld %ld", &pages, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(fp);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/** driving **/
+
+// keys for one action. Edits are steered back toward target bytes
+static void soakAction(struct soakKeys *k, long long bytes, long long target) {
+  char num[32];
+  int r = soakRand() % 100;
+  if(bytes > target + target / 10 && r < 45) {
+    r = 45; // too big: delete instead of typing or pasting
+  } else if(bytes < target - target / 10 && r >= 45 && r < 65) {
+    r = 35; // too small: paste instead of deleting
+  }
+
+  if(r < 35) {
+    // type at a random line, now and then starting a new one
+    snprintf(num, sizeof(num), "\x07%d\r", 1 + (int) (soakRand() % (E.numrows ? E.numrows : 1)));
+    soakAppendStr(k, num);
+    soakAppendStr(k, soakRand() % 2 ? "\x1b[F" : "\x1b[C\x1b[C");
+    if(soakRand() % 3 == 0) {
+      soakAppendStr(k, "\r");
+    }
+    soakWordsOf(k, 5 + soakRand() % 75);
+  } else if(r < 45) {
+    // a paste: many lines arriving at once
+    int lines = 5 + soakRand() % 56;
+    int j;
+    for(j = 0; j < lines; j++) {
+      soakRepeat(k, "  ", soakRand() % 4);
+      soakWordsOf(k, 20 + soakRand() % 80);
+      soakAppendStr(k, "\r");
+    }
+  } else if(r < 65) {
+    // delete a range, joining lines as it goes
+    soakRepeat(k, soakRand() % 2 ? "\x7f" : "\x1b[3~", 10 + soakRand() % 1500);
+  } else if(r < 80) {
+    static const char *moves[] = { "\x1b[6~", "\x1b[5~", "\x1b[A", "\x1b[B", "\x1b[H" };
+    soakRepeat(k, moves[soakRand() % 5], 1 + soakRand() % 20);
+  } else if(r < 90) {
+    // search, then either stay on the match or back out
+    soakAppendStr(k, "\x06");
+    soakAppendStr(k, soakWords[soakRand() % SOAK_NWORDS]);
+    soakAppendStr(k, soakRand() % 2 ? "\r" : "\x1b");
+  } else if(r < 95) {
+    soakAppendStr(k, soakRand() % 20 ? "\x0f" : "\x15");
+  } else {
+    soakAppendStr(k, "\x13");
+  }
+}
+
+// feed keys through the real key handling, one frame per key
+static void soakRun(struct soakKeys *k) {
+  E.headless.input = k->b;
+  E.headless.inputlen = k->len;
+  E.headless.inputpos = 0;
+  E.headless.quit = 0;
+  while(E.headless.inputpos < E.headless.inputlen && !E.headless.quit) {
+    editorScreenRefresh();
+    editorProcessKeypress();
+  }
+  E.headless.input = NULL;
+  E.headless.inputlen = 0;
+}
+
+/** main **/
+
+int main(int argc, char *argv[]) {
+  // chunks parked in glibc's per-thread cache count as in use, which
+  // would look like a slow leak, so run with the cache off
+  if(getenv("CONCHPAD_SOAK_CHILD") == NULL) {
+    setenv("CONCHPAD_SOAK_CHILD", "1", 1);
+    setenv("GLIBC_TUNABLES", "glibc.malloc.tcache_count=0", 1);
+    execv("/proc/self/exe", argv);
+  }
+
+  double hours = 4;
+  int lines = 100000;
+  int sample = 0;
+  int seconds = 0;
+  long leak_kb = 64;
+  double growth = 25;
+  const char *csv = NULL;
+
+  int i;
+  for(i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+      hours = atof(argv[++i]);
+    } else if(strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+      lines = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--sample") == 0 && i + 1 < argc) {
+      sample = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      soakSeed = strtoul(argv[++i], NULL, 10);
+    } else if(strcmp(argv[i], "--leak-kb") == 0 && i + 1 < argc) {
+      leak_kb = atol(argv[++i]);
+    } else if(strcmp(argv[i], "--growth") == 0 && i + 1 < argc) {
+      growth = atof(argv[++i]);
+    } else if(strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+      csv = argv[++i];
+    } else {
+      fprintf(stderr, "usage: soakbench [--hours H] [--lines N] [--sample N] [--seconds S]\n"
+        "                 [--seed N] [--leak-kb KB] [--growth PCT] [--csv FILE]\n");
+      return 2;
+    }
+  }
+
+  long actions = hours * SOAK_ACTIONS_PER_HOUR;
+  if(actions < 10) {
+    actions = 10;
+  }
+  if(sample < 1) {
+    sample = actions / 40 > 0 ? actions / 40 : 1;
+  }
+
+  // the file being edited
+  char path[] = "/tmp/conchpad-soak-XXXXXX.c";
+  int fd = mkstemps(path, 2);
+  if(fd == -1) {
+    perror("mkstemps");
+    return 1;
+  }
+  FILE *fp = fdopen(fd, "w");
+  struct soakKeys k = {NULL, 0, 0};
+  int j;
+  for(j = 0; j < lines; j++) {
+    k.len = 0;
+    soakRepeat(&k, "  ", soakRand() % 4);
+    soakWordsOf(&k, 10 + soakRand() % 70);
+    fwrite(k.b, 1, k.len, fp);
+    fputc(soakRand() % 8 ? ';' : '{', fp);
+    fputc('\n', fp);
+  }
+  fclose(fp);
+
+  FILE *out = csv ? fopen(csv, "w") : NULL;
+  if(csv && out == NULL) {
+    perror(csv);
+    return 1;
+  }
+
+  E.headless.active = 1;
+  if(vscreenInit(&E.headless.screen, 24, 80) == -1) {
+    return 1;
+  }
+  initEditor();
+
+  // baseline: what an open / close of this file leaves behind
+  editorOpen(path);
+  editorScreenRefresh();
+  editorCloseFile();
+  size_t baseline = mallinfo2().uordblks;
+
+  editorOpen(path);
+  long long target = soakBufferBytes();
+  long long start = editorNow();
+  long warm_rss = 0;
+
+  printf("%9s %8s %8s %10s %10s %10s %10s %6s %10s %10s\n", "actions", "secs", "rows",
+    "buffer_kb", "rss_kb", "inuse_kb", "free_kb", "frag%", "key_p50_us", "key_p99_us");
+  if(out) {
+    fprintf(out, "actions,secs,rows,buffer_kb,rss_kb,heap_inuse_kb,heap_free_kb,mmap_kb,frag_pct,"
+      "key_p50_us,key_p99_us\n");
+  }
+
+  long done;
+  for(done = 1; done <= actions; done++) {
+    k.len = 0;
+    soakAction(&k, soakBufferBytes(), target);
+    soakRun(&k);
+
+    double secs = (editorNow() - start) / 1e9;
+    int last = done == actions || (seconds && secs >= seconds);
+    if(done % sample != 0 && !last) {
+      continue;
+    }
+
+    struct mallinfo2 mi = mallinfo2();
+    long rss = soakRssKb();
+    double frag = mi.arena ? 100.0 * mi.fordblks / mi.arena : 0;
+    if(warm_rss == 0 && done >= actions / 10) {
+      warm_rss = rss;
+    }
+
+    printf("%9ld %8.1f %8d %10lld %10ld %10zu %10zu %6.1f %10.1f %10.1f\n", done, secs, E.numrows,
+      soakBufferBytes() / 1024, rss, mi.uordblks / 1024, mi.fordblks / 1024, frag,
+      hdrPercentile(&E.latency.key, 50) / 1e3, hdrPercentile(&E.latency.key, 99) / 1e3);
+    if(out) {
+      fprintf(out, "%ld,%.1f,%d,%lld,%ld,%zu,%zu,%zu,%.1f,%.1f,%.1f\n", done, secs, E.numrows,
+        soakBufferBytes() / 1024, rss, mi.uordblks / 1024, mi.fordblks / 1024, mi.hblkhd / 1024,
+        frag, hdrPercentile(&E.latency.key, 50) / 1e3, hdrPercentile(&E.latency.key, 99) / 1e3);
+      fflush(out);
+    }
+    fflush(stdout);
+
+    // percentiles per sampling window
+    hdrInit(&E.latency.key);
+    if(last) {
+      break;
+    }
+  }
+
+  long end_rss = soakRssKb();
+  editorCloseFile();
+  long long leaked = (long long) mallinfo2().uordblks - (long long) baseline;
+
+  int failed = 0;
+  printf("\nactions %ld, heap left after close %+lld bytes (baseline %zu)\n",
+    done > actions ? actions : done, leaked, baseline);
+  if(leaked > leak_kb * 1024) {
+    printf("LEAK: %lld KB still allocated after closing the file\n", leaked / 1024);
+    failed = 1;
+  }
+  if(warm_rss && end_rss > warm_rss * (1 + growth / 100)) {
+    printf("GROWTH: RSS %ld KB -> %ld KB after warm-up (more than %.0f%%)\n", warm_rss, end_rss, growth);
+    failed = 1;
+  }
+  if(!failed) {
+    printf("ok: no leak, RSS %ld KB -> %ld KB after warm-up\n", warm_rss, end_rss);
+  }
+
+  if(out) {
+    fclose(out);
+  }
+  free(k.b);
+  unlink(path);
+  return failed;
+}
@@ -0,0 +1,86 @@
+/*
+* alloc.h
+*
+* Counting wrappers around malloc and friends. Every call site gets its
+* own counters (calls, bytes requested, frees) and is tagged with the
+* subsystem it belongs to, so benchmarks can check how many allocations
+* an operation costs and a report can show where they come from.
+* Optionally the stack of every allocation is recorded as well.
+*
+* Use the ALLOC_* macros rather than the functions; they create the
+* per-site counters.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_ALLOC_H
+#define CONCHPAD_ALLOC_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+enum allocSubsystem {
+  ALLOC_ROWS = 0, // row text and the row array
+  ALLOC_RENDER, // rendered rows, frame buffers, the virtual screen
+  ALLOC_SYNTAX, // highlight classes and the outline
+  ALLOC_INDEX, // line, bracket, fold and time indexes
+  ALLOC_IO, // loading, saving, file names
+  ALLOC_UI, // prompts, pickers, key scripts
+  ALLOC_SUBSYSTEMS
+};
+
+#define ALLOC_STACK_DEPTH 24 // frames kept per recorded stack
+#define ALLOC_STACKS 4096 // distinct stacks kept
+
+struct allocSite {
+  const char *file;
+  int line;
+  int subsystem;
+  long long calls; // malloc / calloc / realloc / strdup calls
+  long long bytes; // bytes requested by those calls
+  long long frees;
+  int registered;
+  struct allocSite *next;
+};
+
+struct allocStats {
+  long long calls;
+  long long bytes;
+  long long frees;
+};
+
+#define ALLOC_SITE(sub) ({ \
+    static struct allocSite allocSite_ = {__FILE__, __LINE__, sub, 0, 0, 0, 0, NULL}; \
+    &allocSite_; \
+  })
+
+#define ALLOC_MALLOC(sub, size) allocMalloc(ALLOC_SITE(sub), size)
+#define ALLOC_CALLOC(sub, n, size) allocCalloc(ALLOC_SITE(sub), n, size)
+#define ALLOC_REALLOC(sub, ptr, size) allocRealloc(ALLOC_SITE(sub), ptr, size)
+#define ALLOC_STRDUP(sub, s) allocStrdup(ALLOC_SITE(sub), s)
+#define ALLOC_FREE(sub, ptr) allocFree(ALLOC_SITE(sub), ptr)
+
+void *allocMalloc(struct allocSite *site, size_t size);
+void *allocCalloc(struct allocSite *site, size_t n, size_t size);
+void *allocRealloc(struct allocSite *site, void *ptr, size_t size);
+char *allocStrdup(struct allocSite *site, const char *s);
+void allocFree(struct allocSite *site, void *ptr);
+
+// totals for one subsystem, or for everything with ALLOC_SUBSYSTEMS
+void allocTotals(int subsystem, struct allocStats *out);
+
+// allocation calls made so far, for before / after comparisons
+long long allocCount();
+
+// record the stack of every allocation from now on (slow)
+void allocRecordStacks(int on);
+
+// per subsystem and per site tables, then the recorded stacks folded
+// (outermost frame first, one stack per line)
+void allocReport(FILE *fp);
+
+// write the report to path when the process exits
+void allocReportAtExit(const char *path);
+
+#endif
@@ -0,0 +1,51 @@
+/*
+* bracketindex.h
+*
+* Segment tree over per-row bracket summaries. For every bracket kind a
+* row contributes its depth change and the lowest depth reached inside it
+* (relative to the start of the row). Combining the two lets us find the
+* row holding a partner bracket in O(log n), however far away it is.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_BRACKETINDEX_H
+#define CONCHPAD_BRACKETINDEX_H
+
+#define BRACKET_KINDS 3 // (), [], {}
+
+struct bracketSummary {
+  int delta; // opens minus closes
+  int min; // lowest depth at any boundary in the row, start included (<= 0)
+};
+
+typedef struct bracketIndex {
+  struct bracketSummary *tree[BRACKET_KINDS]; // 1-based, leaves at [size, 2 * size)
+  int n; // rows indexed
+  int size; // leaves allocated (power of two)
+  int valid; // cleared on row insert / delete, rebuilt lazily
+} bracketIndex;
+
+// fills the summaries of row i for every kind
+typedef void (*bracketIndexRowFn)(int i, struct bracketSummary *out, void *ctx);
+
+void bracketIndexInit(bracketIndex *bi);
+void bracketIndexFree(bracketIndex *bi);
+
+// rebuild from scratch in O(n)
+void bracketIndexBuild(bracketIndex *bi, int n, bracketIndexRowFn row, void *ctx);
+
+// replace the summaries of row i in O(log n)
+void bracketIndexSet(bracketIndex *bi, int i, const struct bracketSummary *s);
+
+// depth of the given kind at the start of row i
+int bracketIndexPrefix(const bracketIndex *bi, int kind, int i);
+
+// first row j >= from whose lowest depth is <= target, or -1
+int bracketIndexFindNext(const bracketIndex *bi, int kind, int from, int target);
+
+// last row j < before whose lowest depth is <= target, or -1
+int bracketIndexFindPrev(const bracketIndex *bi, int kind, int before, int target);
+
+#endif
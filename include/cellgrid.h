@@ -0,0 +1,64 @@
+/*
+* cellgrid.h
+*
+* A grid of character cells the renderer can draw into instead of
+* writing escape sequences, for hosts that composite the editor into a
+* pane of their own. Each frame records the rectangles whose cells
+* changed, so the host only repaints those.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_CELLGRID_H
+#define CONCHPAD_CELLGRID_H
+
+#define CELL_COLOR 0x00ff // SGR foreground color (30-37), 0 for the default
+#define CELL_REVERSE (1 << 8)
+#define CELL_DIM (1 << 9)
+
+#define CELLGRID_DAMAGE 32 // rectangles kept per frame, merged beyond that
+
+typedef struct gridCell {
+  unsigned int ch; // code point, 0 for the right half of a wide character
+  unsigned char width; // columns taken: 1, 2 when wide, 0 for a right half
+  unsigned short style; // color | CELL_* flags
+} gridCell;
+
+typedef struct gridRect {
+  int x;
+  int y;
+  int w;
+  int h;
+} gridRect;
+
+typedef struct cellGrid {
+  int rows;
+  int cols;
+  gridCell *cells; // rows * cols, owned by the caller
+  int cursor_x;
+  int cursor_y;
+  gridRect damage[CELLGRID_DAMAGE]; // what the last frame changed
+  int ndamage;
+  gridCell *line; // the row being drawn
+  int x; // next column of line
+} cellGrid;
+
+// set the grid up over cells (rows * cols of them) and blank it, so the
+// first frame's damage is measured against an empty pane
+int cellGridInit(cellGrid *g, gridCell *cells, int rows, int cols);
+void cellGridFree(cellGrid *g);
+
+// start a frame: forget the previous frame's damage
+void cellGridBegin(cellGrid *g);
+
+// append UTF-8 text in style to the row being drawn, clipped to the grid.
+// Combining marks and other zero width code points take no cell and are
+// left out
+void cellGridText(cellGrid *g, const char *s, int len, int style);
+
+// blank the rest of the row being drawn and store it as row y, damaging
+// whatever changed
+void cellGridEndRow(cellGrid *g, int y);
+
+#endif
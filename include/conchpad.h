@@ -0,0 +1,68 @@
+/*
+* conchpad.h
+*
+* libconchpad: the ConchPad buffer engine (rows, edits, search, save) for
+* embedding in another program such as ConchShell. Every call takes the
+* buffer it works on, so any number of buffers can stay resident and
+* different buffers can be used from different threads at once; a single
+* buffer must only be used by one thread at a time.
+*
+* Positions are 0-based (row, byte column). Functions returning int give
+* -1 with errno set on failure.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_H
+#define CONCHPAD_H
+
+#include <stddef.h>
+
+#include "cellgrid.h"
+
+typedef struct cpBuffer cpBuffer;
+
+// an empty, unnamed buffer
+cpBuffer *cpBufferNew();
+
+// a buffer holding filename, NULL with errno set if it can't be read
+cpBuffer *cpBufferOpen(const char *filename);
+
+void cpBufferFree(cpBuffer *buf);
+
+// contents
+int cpBufferRows(cpBuffer *buf);
+const char *cpBufferRow(cpBuffer *buf, int at, int *len);
+char *cpBufferContents(cpBuffer *buf, size_t *len); // the whole file
+void cpBufferFreeContents(char *contents); // release what cpBufferContents returned
+
+// edits. Newlines in text start new rows and deleting across the end of
+// a row joins it with the next one
+int cpBufferInsert(cpBuffer *buf, int row, int col, const char *text, size_t len);
+int cpBufferDelete(cpBuffer *buf, int row, int col, size_t len);
+int cpBufferInsertRow(cpBuffer *buf, int at, const char *text, size_t len);
+int cpBufferDeleteRow(cpBuffer *buf, int at);
+
+// the next row after from (before it when dir is -1) containing query,
+// wrapping around; -1 when there is none
+int cpBufferFind(cpBuffer *buf, const char *query, int from, int dir, int *col);
+
+// files. cpBufferSave writes to filename, or to the buffer's own file
+// when it is NULL, and returns the bytes written. The buffer only takes
+// filename as its own once it was written
+const char *cpBufferFilename(cpBuffer *buf);
+int cpBufferDirty(cpBuffer *buf);
+int cpBufferSave(cpBuffer *buf, const char *filename);
+
+// view. cpBufferRender draws the buffer the way the editor shows it
+// (text, status bar and message bar) into grid, sizing the view to the
+// grid, and leaves the changed rectangles in grid->damage
+int cpBufferRender(cpBuffer *buf, cellGrid *grid);
+void cpBufferSetCursor(cpBuffer *buf, int row, int col);
+
+// run a slice of background work (highlighting, indexing); returns
+// nonzero while more is queued
+int cpBufferIdle(cpBuffer *buf);
+
+#endif
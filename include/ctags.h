@@ -0,0 +1,33 @@
+/*
+* ctags.h
+*
+* Go-to-definition through a ctags "tags" file. The file is mmap'd and
+* binary searched in place with sortedSeekLower, so a lookup touches
+* O(log n) pages however big the tags file is.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_CTAGS_H
+#define CONCHPAD_CTAGS_H
+
+#include <limits.h>
+
+struct ctagsEntry {
+  char file[PATH_MAX]; // target file, resolved against the tags file's directory
+  char pattern[1024]; // search pattern with the /^ $/ anchors and escapes removed
+  int anchored; // pattern had a trailing $ (must match the whole line)
+  int line; // line number (1-based) from the address or a line: field, 0 if unknown
+  int matches; // number of tags with this name
+};
+
+// find the tags file for a source file: "tags" in its directory or the
+// closest parent that has one. Returns 0 and fills path, or -1
+int ctagsFind(const char *filename, char *path, size_t pathcap);
+
+// look up the nth (0-based) definition of name in the tags file. Returns
+// 0 on success, -1 if there is no such tag or the file can't be read
+int ctagsLookup(const char *tagspath, const char *name, int nth, struct ctagsEntry *entry);
+
+#endif
@@ -0,0 +1,49 @@
+/*
+* daemon.h
+*
+* Client / server mode. `ConchPad --daemon` keeps buffers open in memory
+* and listens on a Unix domain socket; `ConchPad --attach file` hands its
+* terminal to the daemon (SCM_RIGHTS) and waits until the user detaches
+* with Ctrl-Q. Reopening a resident file is then just a repaint, and
+* several terminals can be attached to the same buffers at once.
+*
+* Each attached terminal is served by its own thread. The editor itself
+* runs under one lock, released while a terminal waits for input, and
+* every terminal keeps its own cursor and scroll position.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_DAEMON_H
+#define CONCHPAD_DAEMON_H
+
+#include <stddef.h>
+
+#define DAEMON_MAGIC "CPAT1" // start of every attach request
+
+struct daemonSession;
+
+// $XDG_RUNTIME_DIR/conchpad.sock, or conchpad.sock in a private 0700
+// /tmp/conchpad-UID directory without it. Returns -1 with errno set when
+// that directory can't be made or isn't safe to use
+int daemonSocketPath(char *buf, size_t bufsize);
+
+// load files, then serve attach requests on path until killed. Returns
+// 1 if it can't listen (or another daemon already is)
+int daemonServe(const char *path, char **files, int nfiles);
+
+// hand the terminal to the daemon to edit filename (NULL for whatever
+// was shown last) and wait for the user to detach. Returns the exit
+// status, or -1 when there is no daemon to attach to. The terminal is
+// only passed to a daemon running as the same user
+int daemonAttach(const char *path, const char *filename);
+
+// hooks the editor calls for a terminal owned by a session: wait for a
+// key with the editor unlocked, detach (Ctrl-Q), and drop a terminal
+// that went away (does not return)
+void daemonWait(struct daemonSession *s);
+void daemonDetach(struct daemonSession *s);
+void daemonHangup(struct daemonSession *s);
+
+#endif
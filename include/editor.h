@@ -0,0 +1,243 @@
+/*
+* editor.h
+*
+* Editor core shared by the ConchPad binary and the benchmarks: the row
+* and editor state, and the entry points used to drive it.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_EDITOR_H
+#define CONCHPAD_EDITOR_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <termios.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "lineindex.h"
+#include "bracketindex.h"
+#include "syntax.h"
+#include "vscreen.h"
+#include "cellgrid.h"
+#include "hdrhist.h"
+
+/** defines **/
+
+#define ConchPad_VERSION "0.0.1"
+#define ConchPad_TAB_STOP 8
+#define ConchPad_QUIT_TIMES 2
+#define ConchPad_TIME_SAMPLE 64 // rows between time index samples
+#define ConchPad_TIME_SLICE 4096 // samples taken per idle slice
+#define ConchPad_HL_LOOKBACK 256 // rows lexed above the viewport to find a known state
+#define ConchPad_HL_SLICE 2000 // rows lexed per idle slice
+#define ConchPad_HL_THREADS 8 // max worker threads for parallel highlighting
+#define ConchPad_HL_BATCH 65536 // rows lexed per idle slice when using threads
+#define ConchPad_MEMORY_BUDGET (512LL << 20) // bytes shared by all open buffers
+#define ConchPad_INDEX_WALK 4096 // rows summed past a stale line index before rebuilding it
+
+// background task results
+#define IDLE_PENDING 1 // the task has more work queued
+#define IDLE_REPAINT 2 // the task changed something on screen
+
+// Takes the control key and bitwise-ANDS the character value with 00011111
+// this basically mimics what the terminal already does by stripping bits 5 & 6
+// from the key combination
+#define CTRL_KEY(k) ((k) & 0x1f) // define what the CTRL_KEY bytecode is
+
+enum editorKey {
+  BACKSPACE = 127,
+  ARROW_LEFT = 1000,
+  ARROW_RIGHT = 2000,
+  ARROW_UP = 3000,
+  ARROW_DOWN = 4000,
+  PAGE_UP,
+  PAGE_DOWN,
+  HOME_KEY,
+  END_KEY,
+  DEL_KEY
+};
+
+/** data **/
+
+struct daemonSession;
+
+// struct containing info about a row in the editor
+typedef struct erow {
+  int idx; // index of this row within the file
+  int size; // length of a row in the filestream
+  int rsize; // render size
+  int cap; // bytes allocated for chars
+  int rcap; // bytes allocated for render
+  int hlcap; // bytes allocated for hl
+  char *chars; // content of a row in the filestream
+  char *render; // render contents
+  unsigned char *hl; // highlight class of each render byte
+  int hl_instate; // lexer state the row was highlighted from (-1 until highlighted)
+  int hl_state; // lexer state at the end of the row
+  int sym; // render offset of the symbol this row defines (-1 for none)
+  int sym_len; // length of the symbol name
+  int sym_kind; // SYM_* kind of the symbol
+  int fold; // rows hidden below this one while it is folded (0 when open)
+  int hidden; // number of folds hiding this row
+  struct bracketSummary brackets[BRACKET_KINDS]; // bracket depth summary, strings / comments skipped
+} erow;
+
+// sampled time -> row index for log files, built in the background
+struct timeIndex {
+  int fmt; // detected timestamp format (TS_NONE until detected)
+  long long *times; // timestamp of each sample, non-decreasing for sorted logs
+  int *rows; // row the sample was taken from
+  int count; // number of samples
+  int cap; // allocated samples
+  int next; // next row to sample from
+  int done; // set once every row has been sampled
+};
+
+// rows defining a symbol, kept sorted by row
+struct outline {
+  int *rows;
+  int count;
+  int cap;
+};
+
+// a --headless run: keys come from a script and frames go to a virtual screen
+struct headless {
+  int active;
+  char *input; // terminal bytes produced from the key script
+  size_t inputlen;
+  size_t inputpos;
+  size_t keyend; // end of the key being read; decoding never reads past it
+  vscreen screen;
+  int quit; // set by Ctrl-Q or once the script runs out
+  long long keys; // keys read
+  long long frames; // frames written
+  long long bytes; // bytes written to the screen
+};
+
+// responsiveness measurements, see the latency section
+struct latency {
+  hdrHist key; // key read -> its frame fully written (ns)
+  hdrHist frame; // time to build and write a frame (ns)
+  hdrHist bytes; // bytes written per frame
+  long long key_ns; // when the key being handled was read (0 once painted)
+  int overlay; // show live percentiles on the message bar
+  char *dump; // file the histograms are written to on exit (--latency)
+};
+
+struct editorConfig {
+  int cx; // cursor x pos
+  int cy; // cursor y pos
+  int rx; // horizontal coordinate (required for handling tabs)
+  int rowoff; // row offset
+  int coloff; // column offset
+  int screenrows; // column size of the screen
+  int screencols; // row size of the screen
+  int numrows; // number of rows in the filestream
+  int rowcap; // rows allocated in row
+  erow *row; // contents of the rows in the filestream
+  int dirty; // a file is dirty if unsaved changes have occurred
+  lineIndex lineidx; // prefix sums of row byte lengths (size + newline)
+  bracketIndex bracketidx; // bracket depth summaries for matching across rows
+  lineIndex foldidx; // 1 per shown row, 0 per folded away row
+  struct outline outline; // symbols found by the highlighter
+  int folds; // number of folded headers
+  struct timeIndex timeidx; // timestamp samples for log navigation
+  char *filename; // save a copy of the openned file's name
+  long long mtime; // modification time (ns) of the file when loaded or saved
+  dev_t dev; // which file that is, to recognize it under another name
+  ino_t ino;
+  struct editorSyntax *syntax; // highlighting rules for the file, NULL for plain text
+  int hl_frontier; // every row above this one is highlighted from its true state
+  int match_row; // partner of the bracket under the cursor (-1 if none)
+  int match_rx; // render column of the partner
+  unsigned long long shown; // when the buffer was last switched to, for eviction order
+  int evicted; // render / highlight caches and indexes were dropped
+  int viewers; // daemon sessions showing the buffer; it isn't evicted while any are
+  long long textbytes; // row text allocated, kept current for the memory budget
+  long long cachebytes; // row render and highlight allocated, likewise
+  struct headless headless; // scripted run state (--headless)
+  struct latency latency; // keystroke to paint histograms
+  char statusmsg[80]; // storing the status message string
+  time_t statusmsg_time; // storing the status message time
+  struct termios orig_termios;
+  int ttyin; // terminal the keys are read from
+  int ttyout; // terminal frames are written to
+  struct daemonSession *session; // daemon client owning the terminal, NULL if none
+};
+
+// the state every editor function works on. Each thread has its own
+// pointer, starting out at the terminal editor's state; libconchpad
+// points it at a buffer's state for the length of a call
+extern __thread struct editorConfig *editorState;
+#define E (*editorState)
+
+/** editor api **/
+
+// terminal
+int editorRawMode(int fd, struct termios *orig);
+void enableRawMode();
+void die(const char *string);
+void editorWrite(const char *buf, size_t len);
+int editorReadKey();
+
+// rows
+void editorInsertRow(int at, char *string, size_t len);
+void editorDelRow(int at);
+int editorRowRender(erow *row);
+void editorUpdateRow(erow *row);
+void editorRowInsertString(erow *row, int at, const char *string, size_t len);
+void editorRowAppendString(erow *row, char *string, size_t len);
+void editorRowDelString(erow *row, int at, int len);
+void editorInsertChar(int c);
+void editorInsertNewLine();
+void editorDelChar();
+void editorSelectSyntaxHighlight();
+
+// files
+long long editorStatTime(const struct stat *st);
+int editorLoad(const char *filename);
+void editorOpen(char *filename);
+void editorCloseFile();
+int editorSaveFile();
+void editorSave();
+char *editorRowsToString(int *buflen);
+
+// buffers
+void editorBufferRegister();
+int editorBufferRecent();
+int editorBufferCount();
+int editorBufferCurrent();
+int editorBufferAdd(const char *filename);
+int editorBufferFind(const char *filename);
+int editorBufferOpen(const char *filename);
+void editorBufferSwitch(int at);
+void editorBufferRestore();
+void editorBufferSetBudget(long long bytes);
+void editorBufferBudget();
+long long editorBufferBytes(struct editorConfig *b, long long *caches);
+
+// search
+int editorFindRow(const char *query, int from, int dir, int *col);
+
+// output and input
+void editorScreenRefresh();
+int editorRenderCells(cellGrid *grid);
+void editorSetStatusMessage(const char *fmt, ...);
+char *editorPrompt(char *prompt, void (*callback)(char *, int, void *), void *arg);
+void editorCursorMove(int key);
+void editorProcessKeypress();
+int editorIdle();
+
+// timing
+long long editorNow();
+void editorLatencyDump();
+int editorHeadlessRun(const char *filename, const char *dump);
+
+void editorInitState();
+void editorFreeState();
+void initEditor();
+
+#endif
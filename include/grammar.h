@@ -0,0 +1,72 @@
+/*
+* grammar.h
+*
+* Syntax definitions loaded from data files at runtime. Each grammar is
+* compiled into a table driven DFA (one transition per state and input
+* byte) plus a perfect hash keyword table, and the compiled form is cached
+* on disk keyed by a hash of the grammar source so startup doesn't
+* recompile anything that hasn't changed.
+*
+* Grammar files are named <lang>.grammar and searched for in
+* $CONCHPAD_SYNTAX_DIR, ~/.config/conchpad/syntax and the syntax directory
+* next to the ConchPad binary. See syntax/c.grammar for the format.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_GRAMMAR_H
+#define CONCHPAD_GRAMMAR_H
+
+#include <stdint.h>
+
+#include "keywords.h"
+#include "syntax.h"
+
+#define GRAMMAR_MAX_QUOTES 4
+
+struct grammar {
+  char *path; // grammar file this was loaded from
+  uint64_t hash; // hash of the grammar source (and its keyword files)
+  int compiled; // tables are ready (built or loaded from the cache)
+  int broken; // compiling failed, never try again
+
+  // source
+  char *name;
+  char **filematch;
+  char *line_comment;
+  char *block_start;
+  char *block_end;
+  char quotes[GRAMMAR_MAX_QUOTES + 1];
+  char escape;
+  int numbers;
+  char separators[64];
+  char **words; // keywords followed by types
+  unsigned char *types; // KW_KEYWORD1 / KW_KEYWORD2 for each word
+  int nwords;
+
+  // compiled
+  int nstates;
+  uint16_t *next; // [nstates * 256] next state
+  unsigned char *emit; // [nstates * 256] highlight class of the byte
+  unsigned char *back; // [nstates * 256] earlier bytes recolored (delimiter completed)
+  uint16_t *eol; // [nstates] state carried into the next row
+  unsigned char sep[256]; // 1 for word separators
+  struct kwTable kw;
+  char *kwpool; // keyword storage when loaded from the cache
+
+  struct editorSyntax syntax; // what the rest of the editor sees
+};
+
+// find (loading grammar files on first use) the grammar for a file name.
+// The grammar is compiled before it is returned; NULL if none matches
+struct editorSyntax *grammarSelect(const char *filename);
+
+// highlight a row with a compiled grammar, same contract as syntaxHighlight
+int grammarHighlight(const struct grammar *g, const char *text, int len,
+  unsigned char *hl, int state);
+
+// parse and compile a grammar file without touching the cache (benchmarks)
+struct grammar *grammarLoadFile(const char *path, int usecache);
+
+#endif
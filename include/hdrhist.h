@@ -0,0 +1,43 @@
+/*
+* hdrhist.h
+*
+* Small HDR-style histogram: log-linear buckets with 16 steps per power
+* of two, so any recorded value is kept to within ~6% over the whole
+* 64-bit range in a fixed ~8KB table. Recording is O(1) and allocation
+* free, cheap enough to do on every keystroke.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_HDRHIST_H
+#define CONCHPAD_HDRHIST_H
+
+#include <stdio.h>
+
+#define HDR_SUB_BITS 5 // values below 2^HDR_SUB_BITS get a bucket each
+#define HDR_HALF (1 << (HDR_SUB_BITS - 1))
+#define HDR_BUCKETS ((1 << HDR_SUB_BITS) + (64 - HDR_SUB_BITS) * HDR_HALF)
+
+typedef struct hdrHist {
+  long long counts[HDR_BUCKETS];
+  long long count;
+  long long min;
+  long long max;
+  long long sum;
+} hdrHist;
+
+void hdrInit(hdrHist *h);
+
+// record one (non-negative) value
+void hdrRecord(hdrHist *h, long long value);
+
+// value at percentile p (0-100), reported as the top of its bucket and
+// clamped to the largest value seen. 0 for an empty histogram
+long long hdrPercentile(const hdrHist *h, double p);
+
+// percentile distribution in the HdrHistogram text layout, values divided
+// by scale (e.g. 1000 to print nanoseconds as microseconds)
+void hdrDump(const hdrHist *h, FILE *fp, const char *name, double scale);
+
+#endif
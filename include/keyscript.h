@@ -0,0 +1,35 @@
+/*
+* keyscript.h
+*
+* Keystroke scripts for headless runs. A script is plain text typed as
+* is, except:
+*   - line breaks in the script are ignored (use <enter> or \r)
+*   - \r \t \e \\ \< and \xHH escapes
+*   - named keys in angle brackets: <enter> <esc> <tab> <bs> <del> <up>
+*     <down> <left> <right> <home> <end> <pgup> <pgdn>, and <C-x> for
+*     Ctrl + a letter (or one of @[\]^_)
+*   - a named key may repeat: <down*500>
+* The script is turned into the raw bytes a terminal would send.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_KEYSCRIPT_H
+#define CONCHPAD_KEYSCRIPT_H
+
+#include <stddef.h>
+
+// translate a script into terminal input bytes (malloc'd into *out).
+// Returns 0, or -1 with a message in err for a malformed script
+int keyScriptParse(const char *script, size_t len, char **out, size_t *outlen,
+  char *err, size_t errcap);
+
+// read and parse a script file
+int keyScriptLoad(const char *path, char **out, size_t *outlen, char *err, size_t errcap);
+
+// length of the first keypress in parsed input: an escape sequence or a
+// UTF-8 character stays whole, anything else is one byte
+size_t keyScriptNext(const char *buf, size_t len);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+* keywords.h
+*
+* Minimal perfect hash keyword tables. The tables are generated at build
+* time from syntax/<lang>.keywords by tools/kwgen.c (hash and displace): the
+* key's hash picks a bucket, the bucket's displacement picks the slot, and
+* a single length check + memcmp confirms the hit.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_KEYWORDS_H
+#define CONCHPAD_KEYWORDS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define KW_NONE 0
+#define KW_KEYWORD1 1 // control / storage keywords
+#define KW_KEYWORD2 2 // type keywords (marked with '|' in the keyword files)
+
+struct kwSlot {
+  const char *word;
+  unsigned char len;
+  unsigned char type; // KW_KEYWORD1 or KW_KEYWORD2
+};
+
+struct kwTable {
+  const struct kwSlot *slots; // exactly one slot per keyword
+  const uint16_t *disp; // displacement for each bucket
+  uint32_t nslots;
+  uint32_t nbuckets;
+};
+
+// the hash used by the generator and the lookup; both halves of the 64 bit
+// value are used, the low half for the bucket and the high half for the slot
+static inline uint64_t kwHash(const char *s, int len) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  int i;
+  for(i = 0; i < len; i++) {
+    h ^= (unsigned char) s[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+static inline uint32_t kwSlotFor(uint64_t h, uint32_t disp, uint32_t nslots) {
+  uint32_t x = (uint32_t)(h >> 32) ^ (disp * 0x9e3779b9u);
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  return x % nslots;
+}
+
+// KW_* class of s[0..len), KW_NONE if it is not a keyword
+static inline int kwLookup(const struct kwTable *t, const char *s, int len) {
+  if(t == NULL || t->nslots == 0) {
+    return KW_NONE;
+  }
+
+  uint64_t h = kwHash(s, len);
+  const struct kwSlot *slot =
+    &t->slots[kwSlotFor(h, t->disp[(uint32_t) h % t->nbuckets], t->nslots)];
+
+  if(slot->len == len && memcmp(slot->word, s, len) == 0) {
+    return slot->type;
+  }
+  return KW_NONE;
+}
+
+// number of buckets the displacement search uses for n keys
+uint32_t kwBucketCount(int n);
+
+// find a displacement for every bucket so the n hashed keys map to
+// distinct slots. Fills disp[kwBucketCount(n)] and slot[n] (slot -> key).
+// Returns 0 on success
+int kwBuildDisplacements(const uint64_t *hashes, int n, uint32_t nbuckets,
+  uint16_t *disp, int *slot);
+
+// build a table at runtime (grammars). The slots point at the caller's
+// words, which must outlive the table. Returns 0 on success
+int kwTableBuild(struct kwTable *t, const char **words, const unsigned char *types, int n);
+void kwTableFree(struct kwTable *t);
+
+// the straightforward linear scan, kept as the reference the perfect hash
+// is checked and benchmarked against
+int kwLookupLinear(const struct kwTable *t, const char *s, int len);
+
+// generated tables (obj/keywords_gen.c)
+extern const struct kwTable kw_c;
+extern const struct kwTable kw_python;
+
+#endif
@@ -0,0 +1,48 @@
+/*
+* lineindex.h
+*
+* Fenwick (binary indexed) tree over row byte lengths. Gives O(log n)
+* prefix sums so we can turn a row into a byte offset (and back) without
+* walking every row like editorRowsToString does.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_LINEINDEX_H
+#define CONCHPAD_LINEINDEX_H
+
+typedef struct lineIndex {
+  long long *tree; // 1-based fenwick tree, tree[i] covers a power of two worth of rows
+  int n; // number of rows currently indexed
+  int cap; // allocated slots in tree (not counting slot 0)
+  int valid; // cleared when rows are inserted / removed, rebuilt lazily
+  int upto; // prefix sums of rows [0, upto) are still right while !valid
+} lineIndex;
+
+// callback used to fetch the byte length of row i when (re)building
+typedef long long (*lineIndexLenFn)(int i, void *ctx);
+
+void lineIndexInit(lineIndex *li);
+void lineIndexFree(lineIndex *li);
+
+// rebuild the whole index in O(n) from the given row lengths
+void lineIndexBuild(lineIndex *li, int n, lineIndexLenFn len, void *ctx);
+
+// rows from i on moved: the index needs a rebuild, but prefix sums of the
+// rows above i can still be used
+void lineIndexInvalidate(lineIndex *li, int i);
+
+// add delta bytes to row i
+void lineIndexAdd(lineIndex *li, int i, long long delta);
+
+// number of bytes in rows [0, i)
+long long lineIndexPrefix(const lineIndex *li, int i);
+
+// total number of bytes in the index
+long long lineIndexTotal(const lineIndex *li);
+
+// row containing byte offset, clamped to [0, n - 1] (-1 if the index is empty)
+int lineIndexFind(const lineIndex *li, long long offset);
+
+#endif
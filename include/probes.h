@@ -0,0 +1,90 @@
+/*
+* probes.h
+*
+* Statically defined tracepoints (USDT) for attaching bpftrace, perf or
+* SystemTap to a running editor, e.g.
+*
+*   bpftrace -e 'usdt:./ConchPad:conchpad:frame_end { @bytes = hist(arg0); }'
+*
+* Each probe is a single nop plus an ELF note (.note.stapsdt) describing
+* where its arguments live, so an unattached probe costs next to nothing
+* and nothing is needed at run time. When <sys/sdt.h> is installed it is
+* used; otherwise the note is emitted here in the same format, and on
+* compilers / targets without that support the probes compile away.
+*
+* Arguments are passed as 64-bit signed values (pointers included):
+*   key(key)                      frame_start()
+*   frame_end(bytes, ns)          row_insert(at, len)
+*   row_delete(at, len)           save_start(filename)
+*   save_end(bytes, errno)        search_start(query, from)
+*   search_end(row or -1, rows)   idle_start(task name)
+*   idle_end(task name, IDLE_* flags)
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_PROBES_H
+#define CONCHPAD_PROBES_H
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CONCHPAD_SDT_HEADER 1
+#endif
+#endif
+
+#if defined(CONCHPAD_SDT_HEADER)
+
+#define PROBE(name) DTRACE_PROBE(conchpad, name)
+#define PROBE1(name, a) DTRACE_PROBE1(conchpad, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(conchpad, name, a, b)
+
+#elif defined(__GNUC__) && defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+
+// the note layout of sys/sdt.h: probe address, base address (for
+// prelink adjustment), semaphore (none), provider, name, argument specs
+#define PROBE_NOTE(name, args) \
+  "990: nop\n" \
+  ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+  ".balign 4\n" \
+  ".4byte 992f-991f, 994f-993f, 3\n" \
+  "991: .asciz \"stapsdt\"\n" \
+  "992: .balign 4\n" \
+  "993: .8byte 990b\n" \
+  ".8byte _.stapsdt.base\n" \
+  ".8byte 0\n" \
+  ".asciz \"conchpad\"\n" \
+  ".asciz \"" #name "\"\n" \
+  ".asciz \"" args "\"\n" \
+  "994: .balign 4\n" \
+  ".popsection\n" \
+  ".ifndef _.stapsdt.base\n" \
+  ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+  ".weak _.stapsdt.base\n" \
+  ".hidden _.stapsdt.base\n" \
+  "_.stapsdt.base: .space 1\n" \
+  ".size _.stapsdt.base, 1\n" \
+  ".popsection\n" \
+  ".endif\n"
+
+#define PROBE(name) \
+  __asm__ __volatile__(PROBE_NOTE(name, ""))
+
+#define PROBE1(name, a) \
+  __asm__ __volatile__(PROBE_NOTE(name, "-8@%[a1]") \
+    :: [a1] "nor" ((long long) (a)))
+
+#define PROBE2(name, a, b) \
+  __asm__ __volatile__(PROBE_NOTE(name, "-8@%[a1] -8@%[a2]") \
+    :: [a1] "nor" ((long long) (a)), [a2] "nor" ((long long) (b)))
+
+#else
+
+#define PROBE(name) do { } while(0)
+#define PROBE1(name, a) do { (void) (a); } while(0)
+#define PROBE2(name, a, b) do { (void) (a); (void) (b); } while(0)
+
+#endif
+
+#endif
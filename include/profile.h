@@ -0,0 +1,55 @@
+/*
+* profile.h
+*
+* Sampling profiler for real editing sessions, no perf permissions
+* needed. SIGPROF fires on CPU time (setitimer(ITIMER_PROF)) and the
+* handler records the interrupted stack together with the editor phase
+* the sample was taken in. On exit the samples are written as folded
+* stacks, one "phase;outermost;...;innermost count" per line, ready for
+* flamegraph.pl, speedscope or inferno.
+*
+* The kernel only delivers SIGPROF on its timer tick, so rates above the
+* tick rate (often 250Hz) give no more samples.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_PROFILE_H
+#define CONCHPAD_PROFILE_H
+
+#include <signal.h>
+
+#define PROFILE_DEPTH 48 // frames kept per sample
+#define PROFILE_STACKS 8192 // distinct (phase, stack) pairs kept, a power of two
+#define PROFILE_HZ 997 // default sampling rate, prime so it doesn't beat with timers
+
+enum profilePhase {
+  PROFILE_OTHER = 0,
+  PROFILE_INPUT, // decoding and dispatching keys
+  PROFILE_RENDER, // building and writing frames
+  PROFILE_LOAD,
+  PROFILE_SAVE,
+  PROFILE_SEARCH,
+  PROFILE_BACKGROUND, // idle tasks and their workers
+  PROFILE_PHASES
+};
+
+// per thread, since SIGPROF lands on whichever thread was running
+extern __thread volatile sig_atomic_t profileCurrentPhase;
+
+// enter phase, returning the phase to restore when leaving it
+static inline int profileSetPhase(int phase) {
+  int prev = profileCurrentPhase;
+  profileCurrentPhase = phase;
+  return prev;
+}
+
+// start sampling hz times per second of CPU time and write the folded
+// stacks to path on exit. Returns -1 if the profiler can't be set up
+int profileStart(const char *path, int hz);
+
+// stop sampling and write the folded stacks to path
+int profileWrite(const char *path);
+
+#endif
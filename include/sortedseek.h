@@ -0,0 +1,28 @@
+/*
+* sortedseek.h
+*
+* Binary search over the raw bytes of a sorted, newline separated file.
+* Each probe lands on an arbitrary byte and re-synchronizes to the next
+* line start, so no line index is ever built.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_SORTEDSEEK_H
+#define CONCHPAD_SORTEDSEEK_H
+
+#include <stddef.h>
+
+// byte offset of the first line that compares >= key (byte order, using
+// only the first keylen bytes of each line). Returns len if every line
+// is smaller than the key.
+long long sortedSeekLower(const char *data, size_t len, const char *key, size_t keylen);
+
+// mmap path and run sortedSeekLower over it. On success stores the offset
+// and the first keylen bytes of the line found (NUL terminated, truncated
+// to linecap - 1) and returns 0. Returns -1 with errno set on failure.
+int sortedSeekFile(const char *path, const char *key, size_t keylen,
+  long long *offset, char *line, size_t linecap);
+
+#endif
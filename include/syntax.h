@@ -0,0 +1,77 @@
+/*
+* syntax.h
+*
+* Syntax highlighting database and the row lexer. The lexer is a pure
+* function of (row text, state at the start of the row) so rows can be
+* re-highlighted individually and the caller decides how far a change has
+* to propagate by comparing end states.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_SYNTAX_H
+#define CONCHPAD_SYNTAX_H
+
+#include "keywords.h"
+
+struct grammar;
+
+enum editorHighlight {
+  HL_NORMAL = 0,
+  HL_COMMENT,
+  HL_MLCOMMENT,
+  HL_KEYWORD1,
+  HL_KEYWORD2,
+  HL_STRING,
+  HL_NUMBER
+};
+
+#define HL_HIGHLIGHT_NUMBERS (1 << 0)
+#define HL_HIGHLIGHT_STRINGS (1 << 1)
+
+// lexer state carried from the end of one row into the next. Grammar
+// lexers use their own DFA state numbers, but 0 is always plain text
+#define SYN_STATE_NORMAL 0
+#define SYN_STATE_COMMENT 1 // inside a multi-line comment
+#define SYN_STATE_STRING 0x100 // inside a string continued with '\', OR'd with the quote
+
+struct editorSyntax {
+  char *filetype; // name displayed in the status bar
+  char **filematch; // extensions (starting with '.') or substrings of the file name
+  const struct kwTable *keywords; // generated perfect hash table
+  char *singleline_comment_start;
+  char *multiline_comment_start;
+  char *multiline_comment_end;
+  int flags; // HL_HIGHLIGHT_*
+  const struct grammar *grammar; // compiled grammar, NULL for the built in lexer
+};
+
+// pick the syntax for a file name, NULL if nothing matches
+struct editorSyntax *syntaxSelect(const char *filename);
+
+// highlight len bytes of text into hl starting from state, and return the
+// state at the end of the row. Never touches anything but hl, so it is safe
+// to call from several threads at once
+int syntaxHighlight(const struct editorSyntax *syntax, const char *text, int len,
+  unsigned char *hl, int state);
+
+// kinds of symbol syntaxSymbol picks out for the outline
+enum syntaxSymbolKind {
+  SYM_FUNCTION = 0,
+  SYM_TYPE,
+  SYM_MACRO,
+  SYM_SECTION
+};
+
+// find the symbol a highlighted row defines (function, type, macro or a
+// "/** section **/" marker). Works off the row's text and highlight
+// classes, so it follows whichever lexer produced them. Returns the offset
+// of the name and fills *namelen / *kind, or -1 if the row defines nothing
+int syntaxSymbol(const char *text, int len, const unsigned char *hl, int state,
+  int *namelen, int *kind);
+
+// ANSI foreground color for a highlight class
+int syntaxToColor(int hl);
+
+#endif
@@ -0,0 +1,45 @@
+/*
+* timestamp.h
+*
+* Detect and parse the timestamp prefix of log lines. Times are returned
+* as seconds; formats without a year (syslog) or without a date at all
+* (bare clock times) count from the start of the year / day instead of
+* the epoch, which is all we need for ordering and navigation.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_TIMESTAMP_H
+#define CONCHPAD_TIMESTAMP_H
+
+enum tsFormat {
+  TS_NONE = 0,
+  TS_ISO, // 2025-08-05 14:32:05 or 2025-08-05T14:32:05
+  TS_SYSLOG, // Aug  5 14:32:05
+  TS_CLOCK, // 14:32:05
+  TS_EPOCH // 1754404325 (optionally followed by .fraction)
+};
+
+// parse a timestamp of the given format at the start of line (an optional
+// leading '[' is skipped). Returns 0 on success
+int tsParse(int fmt, const char *line, int len, long long *t);
+
+// return the first format that parses line, or TS_NONE
+int tsDetect(const char *line, int len);
+
+// human readable name of a format for the status bar
+const char *tsFormatName(int fmt);
+
+// format t back into HH:MM:SS (prefixed with the date for TS_ISO)
+int tsFormatTime(int fmt, long long t, char *buf, int bufsize);
+
+// resolve a navigation query against the reference time ref:
+//   "+" / "-"       start of the next / previous minute
+//   "+10s", "-5m"   relative offsets in s, m, h or d
+//   "14:32[:05]"    time of day on ref's day
+//   full timestamp  anything tsParse accepts for fmt
+// Returns 0 on success
+int tsParseQuery(int fmt, const char *query, long long ref, long long *target);
+
+#endif
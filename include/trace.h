@@ -0,0 +1,45 @@
+/*
+* trace.h
+*
+* Begin / end event tracing, written out as Chrome trace JSON (open it in
+* Perfetto or chrome://tracing). Every thread records into its own ring
+* buffer without locks; once a ring is full the oldest events are
+* overwritten. While tracing is off TRACE_BEGIN / TRACE_END cost one
+* predictable branch.
+*
+* Event names must be string literals (only the pointer is stored).
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_TRACE_H
+#define CONCHPAD_TRACE_H
+
+#define TRACE_RING_SIZE (1 << 15) // events kept per thread, a power of two
+
+extern int traceEnabled;
+
+#define TRACE_BEGIN(name) do { \
+    if(__builtin_expect(traceEnabled, 0)) traceEvent(name, 'B'); \
+  } while(0)
+
+#define TRACE_END(name) do { \
+    if(__builtin_expect(traceEnabled, 0)) traceEvent(name, 'E'); \
+  } while(0)
+
+// turn tracing on and write the trace to path when the process exits.
+// Call before any other thread starts
+void traceStart(const char *path);
+
+// record one event ('B'egin or 'E'nd) on the calling thread's ring
+void traceEvent(const char *name, char phase);
+
+// name the calling thread in the trace
+void traceThreadName(const char *name);
+
+// write every ring to path as Chrome trace JSON. Threads still recording
+// may lose their newest events. Returns -1 if path can't be written
+int traceFlush(const char *path);
+
+#endif
@@ -0,0 +1,50 @@
+/*
+* vscreen.h
+*
+* In-memory terminal screen. Understands the subset of VT100 / ANSI the
+* editor emits (cursor positioning, erase, SGR, cursor visibility) so
+* frames can be rendered and inspected without a real terminal.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+#ifndef CONCHPAD_VSCREEN_H
+#define CONCHPAD_VSCREEN_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define VSCREEN_REVERSE (1 << 8) // SGR 7
+#define VSCREEN_DIM (1 << 9) // SGR 2
+
+typedef struct vscreen {
+  int rows;
+  int cols;
+  unsigned char *chars; // rows * cols cells
+  unsigned short *attrs; // foreground color (0 = default) | VSCREEN_* flags
+  int cy; // cursor row
+  int cx; // cursor column
+  int cursor_visible;
+  unsigned short attr; // attribute applied to the next printed cell
+
+  // escape sequence parser, kept across writes
+  int state;
+  char params[32];
+  int nparams;
+} vscreen;
+
+int vscreenInit(vscreen *vs, int rows, int cols);
+void vscreenFree(vscreen *vs);
+
+// feed output bytes, exactly as they would be written to the terminal
+void vscreenWrite(vscreen *vs, const char *buf, size_t len);
+
+// text of row y with trailing blanks trimmed, NUL terminated into out
+// (which must hold cols + 1 bytes)
+void vscreenRow(const vscreen *vs, int y, char *out);
+
+// print every row, one per line
+void vscreenDump(const vscreen *vs, FILE *fp);
+
+#endif
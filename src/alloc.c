@@ -0,0 +1,233 @@
+/*
+* alloc.c
+*
+* Per-site allocation counters and the optional stack recorder
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _GNU_SOURCE
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+/** data **/
+
+struct allocStack {
+  unsigned long long hash; // 0 for an unused slot
+  int depth;
+  void *frames[ALLOC_STACK_DEPTH];
+  long long calls;
+  long long bytes;
+};
+
+static const char *allocSubsystemNames[ALLOC_SUBSYSTEMS] = {
+  "rows", "render", "syntax", "index", "io", "ui"
+};
+
+static struct allocSite *allocSites = NULL; // only ever pushed to
+static int allocStacksOn = 0;
+static struct allocStack *allocStacks = NULL;
+static int allocStacksDropped = 0;
+static pthread_mutex_t allocStackLock = PTHREAD_MUTEX_INITIALIZER;
+static const char *allocPath;
+
+/** recording **/
+
+__attribute__((noinline)) static void allocRecordStack(size_t size) {
+  void *frames[ALLOC_STACK_DEPTH + 2];
+  int depth = backtrace(frames, ALLOC_STACK_DEPTH + 2);
+
+  // drop allocRecordStack and allocCounted themselves
+  depth = depth > 2 ? depth - 2 : 0;
+  unsigned long long hash = 1469598103934665603ULL;
+  int j;
+  for(j = 0; j < depth; j++) {
+    hash = (hash ^ (unsigned long long) (size_t) frames[j + 2]) * 1099511628211ULL;
+  }
+  hash |= 1;
+
+  pthread_mutex_lock(&allocStackLock);
+  unsigned int slot = hash & (ALLOC_STACKS - 1);
+  unsigned int probes;
+  for(probes = 0; probes < ALLOC_STACKS; probes++, slot = (slot + 1) & (ALLOC_STACKS - 1)) {
+    struct allocStack *st = &allocStacks[slot];
+    if(st->hash == 0) {
+      st->hash = hash;
+      st->depth = depth;
+      memcpy(st->frames, &frames[2], sizeof(void *) * depth);
+    }
+    if(st->hash == hash) {
+      st->calls++;
+      st->bytes += size;
+      break;
+    }
+  }
+  if(probes == ALLOC_STACKS) {
+    allocStacksDropped++;
+  }
+  pthread_mutex_unlock(&allocStackLock);
+}
+
+__attribute__((noinline)) static void allocCounted(struct allocSite *site, size_t size) {
+  if(!__atomic_load_n(&site->registered, __ATOMIC_ACQUIRE)) {
+    int unregistered = 0;
+    if(__atomic_compare_exchange_n(&site->registered, &unregistered, 1, 0,
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      site->next = __atomic_load_n(&allocSites, __ATOMIC_RELAXED);
+      while(!__atomic_compare_exchange_n(&allocSites, &site->next, site, 0,
+          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+  }
+
+  __atomic_fetch_add(&site->calls, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&site->bytes, size, __ATOMIC_RELAXED);
+
+  if(__builtin_expect(allocStacksOn, 0)) {
+    allocRecordStack(size);
+  }
+}
+
+/** api **/
+
+void *allocMalloc(struct allocSite *site, size_t size) {
+  allocCounted(site, size);
+  return malloc(size);
+}
+
+void *allocCalloc(struct allocSite *site, size_t n, size_t size) {
+  allocCounted(site, n * size);
+  return calloc(n, size);
+}
+
+void *allocRealloc(struct allocSite *site, void *ptr, size_t size) {
+  allocCounted(site, size);
+  return realloc(ptr, size);
+}
+
+char *allocStrdup(struct allocSite *site, const char *s) {
+  allocCounted(site, strlen(s) + 1);
+  return strdup(s);
+}
+
+void allocFree(struct allocSite *site, void *ptr) {
+  if(ptr == NULL) {
+    return;
+  }
+  __atomic_fetch_add(&site->frees, 1, __ATOMIC_RELAXED);
+  free(ptr);
+}
+
+void allocTotals(int subsystem, struct allocStats *out) {
+  memset(out, 0, sizeof(*out));
+
+  struct allocSite *site;
+  for(site = __atomic_load_n(&allocSites, __ATOMIC_ACQUIRE); site; site = site->next) {
+    if(subsystem == ALLOC_SUBSYSTEMS || site->subsystem == subsystem) {
+      out->calls += __atomic_load_n(&site->calls, __ATOMIC_RELAXED);
+      out->bytes += __atomic_load_n(&site->bytes, __ATOMIC_RELAXED);
+      out->frees += __atomic_load_n(&site->frees, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+long long allocCount() {
+  struct allocStats total;
+  allocTotals(ALLOC_SUBSYSTEMS, &total);
+  return total.calls;
+}
+
+void allocRecordStacks(int on) {
+  if(on && allocStacks == NULL) {
+    allocStacks = calloc(ALLOC_STACKS, sizeof(struct allocStack));
+    if(allocStacks == NULL) {
+      return;
+    }
+  }
+  allocStacksOn = on;
+}
+
+/** report **/
+
+// function name out of a backtrace_symbols line ("bin(func+0x1f) [0x...]")
+static void allocFrameName(const char *symbol, char *buf, size_t bufsize) {
+  const char *open = strchr(symbol, '(');
+  const char *end = open ? strpbrk(open, "+)") : NULL;
+  if(open && end && end > open + 1) {
+    snprintf(buf, bufsize, "%.*s", (int) (end - open - 1), open + 1);
+  } else {
+    const char *addr = strchr(symbol, '[');
+    snprintf(buf, bufsize, "%.*s", addr ? (int) strcspn(addr + 1, "]") : (int) strlen(symbol),
+      addr ? addr + 1 : symbol);
+  }
+}
+
+void allocReport(FILE *fp) {
+  int j;
+
+  fprintf(fp, "# allocations by subsystem\n%-10s %12s %14s %12s\n",
+    "subsystem", "calls", "bytes", "frees");
+  for(j = 0; j <= ALLOC_SUBSYSTEMS; j++) {
+    struct allocStats stats;
+    allocTotals(j, &stats);
+    fprintf(fp, "%-10s %12lld %14lld %12lld\n",
+      j < ALLOC_SUBSYSTEMS ? allocSubsystemNames[j] : "total", stats.calls, stats.bytes, stats.frees);
+  }
+
+  fprintf(fp, "\n# allocations by site\n%12s %14s %12s  %-8s %s\n",
+    "calls", "bytes", "frees", "subsys", "site");
+  struct allocSite *site;
+  for(site = __atomic_load_n(&allocSites, __ATOMIC_ACQUIRE); site; site = site->next) {
+    fprintf(fp, "%12lld %14lld %12lld  %-8s %s:%d\n", site->calls, site->bytes, site->frees,
+      allocSubsystemNames[site->subsystem], site->file, site->line);
+  }
+
+  if(allocStacks == NULL) {
+    return;
+  }
+
+  fprintf(fp, "\n# allocation stacks: frames outermost first, then calls and bytes\n");
+  pthread_mutex_lock(&allocStackLock);
+  for(j = 0; j < ALLOC_STACKS; j++) {
+    struct allocStack *st = &allocStacks[j];
+    if(st->hash == 0) {
+      continue;
+    }
+
+    char **symbols = backtrace_symbols(st->frames, st->depth);
+    int f;
+    for(f = st->depth - 1; f >= 0; f--) {
+      char name[128];
+      allocFrameName(symbols ? symbols[f] : "?", name, sizeof(name));
+      fprintf(fp, "%s%s", name, f ? ";" : "");
+    }
+    fprintf(fp, " %lld %lld\n", st->calls, st->bytes);
+    free(symbols);
+  }
+  if(allocStacksDropped) {
+    fprintf(fp, "# %d allocations on stacks past the first %d not recorded\n",
+      allocStacksDropped, ALLOC_STACKS);
+  }
+  pthread_mutex_unlock(&allocStackLock);
+}
+
+static void allocAtExit() {
+  FILE *fp = fopen(allocPath, "w");
+  if(fp == NULL) {
+    return;
+  }
+  allocReport(fp);
+  fclose(fp);
+}
+
+void allocReportAtExit(const char *path) {
+  allocPath = path;
+  atexit(allocAtExit);
+}
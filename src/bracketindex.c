@@ -0,0 +1,215 @@
+/*
+* bracketindex.c
+*
+* Segment tree used for bracket matching across rows
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "bracketindex.h"
+
+/** helpers **/
+
+static struct bracketSummary bracketCombine(struct bracketSummary a, struct bracketSummary b) {
+  struct bracketSummary s;
+  s.delta = a.delta + b.delta;
+  s.min = a.min < a.delta + b.min ? a.min : a.delta + b.min;
+  return s;
+}
+
+/** bracket index **/
+
+void bracketIndexInit(bracketIndex *bi) {
+  int k;
+  for(k = 0; k < BRACKET_KINDS; k++) {
+    bi->tree[k] = NULL;
+  }
+  bi->n = 0;
+  bi->size = 0;
+  bi->valid = 0;
+}
+
+void bracketIndexFree(bracketIndex *bi) {
+  int k;
+  for(k = 0; k < BRACKET_KINDS; k++) {
+    ALLOC_FREE(ALLOC_INDEX, bi->tree[k]);
+  }
+  bracketIndexInit(bi);
+}
+
+void bracketIndexBuild(bracketIndex *bi, int n, bracketIndexRowFn row, void *ctx) {
+  int size = 1;
+  while(size < n) {
+    size *= 2;
+  }
+
+  int k;
+  if(size != bi->size) {
+    for(k = 0; k < BRACKET_KINDS; k++) {
+      struct bracketSummary *tree = ALLOC_REALLOC(ALLOC_INDEX, bi->tree[k], sizeof(struct bracketSummary) * 2 * size);
+      if(tree == NULL) {
+        bi->valid = 0;
+        return;
+      }
+      bi->tree[k] = tree;
+    }
+    bi->size = size;
+  }
+  bi->n = n;
+
+  int i;
+  struct bracketSummary s[BRACKET_KINDS];
+  for(i = 0; i < size; i++) {
+    if(i < n) {
+      row(i, s, ctx);
+    }
+    for(k = 0; k < BRACKET_KINDS; k++) {
+      if(i < n) {
+        bi->tree[k][size + i] = s[k];
+      } else {
+        bi->tree[k][size + i].delta = 0;
+        bi->tree[k][size + i].min = 0;
+      }
+    }
+  }
+
+  for(k = 0; k < BRACKET_KINDS; k++) {
+    for(i = size - 1; i > 0; i--) {
+      bi->tree[k][i] = bracketCombine(bi->tree[k][2 * i], bi->tree[k][2 * i + 1]);
+    }
+  }
+
+  bi->valid = 1;
+}
+
+void bracketIndexSet(bracketIndex *bi, int i, const struct bracketSummary *s) {
+  if(i < 0 || i >= bi->n) {
+    return;
+  }
+
+  int k;
+  for(k = 0; k < BRACKET_KINDS; k++) {
+    struct bracketSummary *tree = bi->tree[k];
+    int v = bi->size + i;
+    tree[v] = s[k];
+    for(v /= 2; v > 0; v /= 2) {
+      tree[v] = bracketCombine(tree[2 * v], tree[2 * v + 1]);
+    }
+  }
+}
+
+int bracketIndexPrefix(const bracketIndex *bi, int kind, int i) {
+  if(i > bi->n) {
+    i = bi->n;
+  }
+
+  int sum = 0;
+  int l = bi->size;
+  int r = bi->size + i;
+  for(; l < r; l /= 2, r /= 2) {
+    if(l & 1) sum += bi->tree[kind][l++].delta;
+    if(r & 1) sum += bi->tree[kind][--r].delta;
+  }
+  return sum;
+}
+
+// walk the canonical nodes covering [from, n) left to right keeping the
+// depth at the start of each, then descend into the first one that dips
+// to the target
+int bracketIndexFindNext(const bracketIndex *bi, int kind, int from, int target) {
+  if(from < 0) {
+    from = 0;
+  }
+  if(from >= bi->n) {
+    return -1;
+  }
+
+  const struct bracketSummary *tree = bi->tree[kind];
+  int nodes[64];
+  int right[32];
+  int nleft = 0;
+  int nright = 0;
+  int l = bi->size + from;
+  int r = bi->size + bi->n;
+  for(; l < r; l /= 2, r /= 2) {
+    if(l & 1) nodes[nleft++] = l++;
+    if(r & 1) right[nright++] = --r;
+  }
+  while(nright > 0) {
+    nodes[nleft++] = right[--nright];
+  }
+
+  int depth = bracketIndexPrefix(bi, kind, from);
+  int j;
+  for(j = 0; j < nleft; j++) {
+    int v = nodes[j];
+    if(depth + tree[v].min <= target) {
+      while(v < bi->size) {
+        if(depth + tree[2 * v].min <= target) {
+          v = 2 * v;
+        } else {
+          depth += tree[2 * v].delta;
+          v = 2 * v + 1;
+        }
+      }
+      return v - bi->size;
+    }
+    depth += tree[v].delta;
+  }
+
+  return -1;
+}
+
+// the mirror image: canonical nodes covering [0, before) right to left,
+// preferring the right child when descending
+int bracketIndexFindPrev(const bracketIndex *bi, int kind, int before, int target) {
+  if(before > bi->n) {
+    before = bi->n;
+  }
+  if(before <= 0) {
+    return -1;
+  }
+
+  const struct bracketSummary *tree = bi->tree[kind];
+  int nodes[64];
+  int left[32];
+  int nright = 0;
+  int nleft = 0;
+  int l = bi->size;
+  int r = bi->size + before;
+  for(; l < r; l /= 2, r /= 2) {
+    if(l & 1) left[nleft++] = l++;
+    if(r & 1) nodes[nright++] = --r;
+  }
+  while(nleft > 0) {
+    nodes[nright++] = left[--nleft];
+  }
+
+  int end = bracketIndexPrefix(bi, kind, before);
+  int j;
+  for(j = 0; j < nright; j++) {
+    int v = nodes[j];
+    int start = end - tree[v].delta;
+    if(start + tree[v].min <= target) {
+      while(v < bi->size) {
+        int rstart = start + tree[2 * v].delta;
+        if(rstart + tree[2 * v + 1].min <= target) {
+          start = rstart;
+          v = 2 * v + 1;
+        } else {
+          v = 2 * v;
+        }
+      }
+      return v - bi->size;
+    }
+    end = start;
+  }
+
+  return -1;
+}
@@ -0,0 +1,291 @@
+/*
+* conchpad.c
+*
+* libconchpad: handle based access to the editor core. Each buffer owns a
+* whole editorConfig, and every call points this thread's editor state at
+* it for its duration, so the core code runs unchanged on any buffer
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "conchpad.h"
+#include "editor.h"
+#include "alloc.h"
+
+/** data **/
+
+struct cpBuffer {
+  struct editorConfig state;
+};
+
+// switch this thread over to buf, returning the state to switch back to
+static struct editorConfig *cpEnter(cpBuffer *buf) {
+  struct editorConfig *prev = editorState;
+  editorState = &buf->state;
+  return prev;
+}
+
+static void cpLeave(struct editorConfig *prev) {
+  editorState = prev;
+}
+
+/** buffers **/
+
+cpBuffer *cpBufferNew() {
+  cpBuffer *buf = ALLOC_CALLOC(ALLOC_ROWS, 1, sizeof(cpBuffer));
+  if(buf == NULL) {
+    return NULL;
+  }
+
+  struct editorConfig *prev = cpEnter(buf);
+  editorInitState();
+  cpLeave(prev);
+  return buf;
+}
+
+cpBuffer *cpBufferOpen(const char *filename) {
+  cpBuffer *buf = cpBufferNew();
+  if(buf == NULL) {
+    return NULL;
+  }
+
+  struct editorConfig *prev = cpEnter(buf);
+  int loaded = editorLoad(filename);
+  cpLeave(prev);
+
+  if(loaded == -1) {
+    int err = errno;
+    cpBufferFree(buf);
+    errno = err;
+    return NULL;
+  }
+  return buf;
+}
+
+void cpBufferFree(cpBuffer *buf) {
+  if(buf == NULL) {
+    return;
+  }
+
+  struct editorConfig *prev = cpEnter(buf);
+  editorFreeState();
+  cpLeave(prev);
+  ALLOC_FREE(ALLOC_ROWS, buf);
+}
+
+/** contents **/
+
+int cpBufferRows(cpBuffer *buf) {
+  return buf->state.numrows;
+}
+
+const char *cpBufferRow(cpBuffer *buf, int at, int *len) {
+  if(at < 0 || at >= buf->state.numrows) {
+    return NULL;
+  }
+  if(len) {
+    *len = buf->state.row[at].size;
+  }
+  return buf->state.row[at].chars;
+}
+
+char *cpBufferContents(cpBuffer *buf, size_t *len) {
+  struct editorConfig *prev = cpEnter(buf);
+  int buflen;
+  char *contents = editorRowsToString(&buflen);
+  cpLeave(prev);
+
+  if(len) {
+    *len = buflen;
+  }
+  return contents;
+}
+
+void cpBufferFreeContents(char *contents) {
+  ALLOC_FREE(ALLOC_IO, contents);
+}
+
+/** edits **/
+
+int cpBufferInsert(cpBuffer *buf, int row, int col, const char *text, size_t len) {
+  if(row < 0 || row > buf->state.numrows || col < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct editorConfig *prev = cpEnter(buf);
+  int cx = E.cx; // editorInsertNewLine moves the cursor, the host's stays put
+  int cy = E.cy;
+  if(row == E.numrows) {
+    editorInsertRow(E.numrows, "", 0);
+  }
+  if(col > E.row[row].size) {
+    col = E.row[row].size;
+  }
+
+  // each line of text goes in with one row update, splitting the row
+  // wherever text has a newline
+  const char *end = text + len;
+  while(1) {
+    const char *nl = memchr(text, '\n', end - text);
+    size_t n = (nl ? nl : end) - text;
+    editorRowInsertString(&E.row[row], col, text, n);
+    col += n;
+    if(nl == NULL) {
+      break;
+    }
+
+    E.cy = row;
+    E.cx = col;
+    editorInsertNewLine();
+    row++;
+    col = 0;
+    text = nl + 1;
+  }
+  E.cx = cx;
+  E.cy = cy;
+  cpLeave(prev);
+  return 0;
+}
+
+int cpBufferDelete(cpBuffer *buf, int row, int col, size_t len) {
+  if(row < 0 || row >= buf->state.numrows || col < 0 || col > buf->state.row[row].size) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct editorConfig *prev = cpEnter(buf);
+  while(len > 0) {
+    erow *r = &E.row[row];
+    if(col < r->size) {
+      int n = len < (size_t) (r->size - col) ? (int) len : r->size - col;
+      editorRowDelString(r, col, n);
+      len -= n;
+    } else if(row + 1 < E.numrows) {
+      // the newline at the end of the row
+      editorRowAppendString(r, E.row[row + 1].chars, E.row[row + 1].size);
+      editorDelRow(row + 1);
+      len--;
+    } else {
+      break;
+    }
+  }
+  cpLeave(prev);
+  return 0;
+}
+
+int cpBufferInsertRow(cpBuffer *buf, int at, const char *text, size_t len) {
+  if(at < 0 || at > buf->state.numrows) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct editorConfig *prev = cpEnter(buf);
+  editorInsertRow(at, (char *) text, len);
+  cpLeave(prev);
+  return 0;
+}
+
+int cpBufferDeleteRow(cpBuffer *buf, int at) {
+  if(at < 0 || at >= buf->state.numrows) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct editorConfig *prev = cpEnter(buf);
+  editorDelRow(at);
+  cpLeave(prev);
+  return 0;
+}
+
+int cpBufferFind(cpBuffer *buf, const char *query, int from, int dir, int *col) {
+  struct editorConfig *prev = cpEnter(buf);
+  int dummy;
+  int at = editorFindRow(query, from, dir < 0 ? -1 : 1, col ? col : &dummy);
+  cpLeave(prev);
+  return at;
+}
+
+/** files **/
+
+const char *cpBufferFilename(cpBuffer *buf) {
+  return buf->state.filename;
+}
+
+int cpBufferDirty(cpBuffer *buf) {
+  return buf->state.dirty != 0;
+}
+
+int cpBufferSave(cpBuffer *buf, const char *filename) {
+  if(filename == NULL && buf->state.filename == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct editorConfig *prev = cpEnter(buf);
+  if(filename == NULL) {
+    int written = editorSaveFile();
+    cpLeave(prev);
+    return written;
+  }
+
+  // the buffer only takes the new name once the write went through
+  char *old = E.filename;
+  E.filename = ALLOC_STRDUP(ALLOC_IO, filename);
+  if(E.filename == NULL) {
+    E.filename = old;
+    cpLeave(prev);
+    return -1;
+  }
+  int written = editorSaveFile();
+  if(written == -1) {
+    int err = errno;
+    ALLOC_FREE(ALLOC_IO, E.filename);
+    E.filename = old;
+    errno = err;
+  } else {
+    ALLOC_FREE(ALLOC_IO, old);
+    editorSelectSyntaxHighlight();
+  }
+  cpLeave(prev);
+  return written;
+}
+
+/** view **/
+
+int cpBufferRender(cpBuffer *buf, cellGrid *grid) {
+  struct editorConfig *prev = cpEnter(buf);
+  int drawn = editorRenderCells(grid);
+  cpLeave(prev);
+
+  if(drawn == -1) {
+    errno = EINVAL;
+  }
+  return drawn;
+}
+
+void cpBufferSetCursor(cpBuffer *buf, int row, int col) {
+  if(row > buf->state.numrows) {
+    row = buf->state.numrows;
+  }
+  if(row < 0) {
+    row = 0;
+  }
+  int size = row < buf->state.numrows ? buf->state.row[row].size : 0;
+  buf->state.cy = row;
+  buf->state.cx = col < 0 ? 0 : col > size ? size : col;
+}
+
+int cpBufferIdle(cpBuffer *buf) {
+  struct editorConfig *prev = cpEnter(buf);
+  int pending = editorIdle() & IDLE_PENDING;
+  cpLeave(prev);
+  return pending;
+}
@@ -0,0 +1,183 @@
+/*
+* ctags.c
+*
+* ctags lookups straight off the mmap'd tags file
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ctags.h"
+#include "sortedseek.h"
+
+/** helpers **/
+
+static const char *ctagsLineEnd(const char *data, size_t len, size_t pos) {
+  const char *nl = memchr(&data[pos], '\n', len - pos);
+  return nl ? nl : &data[len];
+}
+
+// value of the !_TAG_FILE_SORTED header: 1 sorted, 0 unsorted, 2 case
+// folded. Headers sort first, so this is one more binary search
+static int ctagsSortMode(const char *data, size_t len) {
+  static const char key[] = "!_TAG_FILE_SORTED\t";
+  size_t keylen = sizeof(key) - 1;
+  long long pos = sortedSeekLower(data, len, key, keylen);
+  if((size_t) pos + keylen < len && memcmp(&data[pos], key, keylen) == 0) {
+    return data[pos + keylen] - '0';
+  }
+  return 1; // no header: assume sorted, as ctags writes by default
+}
+
+// split the tag line at pos into its file and address fields
+static void ctagsParse(const char *tagspath, const char *line, const char *end,
+    struct ctagsEntry *entry) {
+  const char *file = memchr(line, '\t', end - line);
+  file = file ? file + 1 : end;
+  const char *address = memchr(file, '\t', end - file);
+  const char *fileend = address ? address : end;
+  address = address ? address + 1 : end;
+
+  // file names are relative to the directory holding the tags file
+  int flen = fileend - file;
+  const char *slash = strrchr(tagspath, '/');
+  if(file[0] == '/' || slash == NULL) {
+    snprintf(entry->file, sizeof(entry->file), "%.*s", flen, file);
+  } else {
+    snprintf(entry->file, sizeof(entry->file), "%.*s/%.*s",
+      (int) (slash - tagspath), tagspath, flen, file);
+  }
+
+  entry->pattern[0] = '\0';
+  entry->anchored = 0;
+  entry->line = 0;
+
+  const char *p = address;
+  if(p < end && (*p == '/' || *p == '?')) {
+    char delim = *p++;
+    if(p < end && *p == '^') {
+      p++;
+    }
+
+    size_t n = 0;
+    while(p < end && *p != delim && n < sizeof(entry->pattern) - 1) {
+      if(*p == '\\' && p + 1 < end) {
+        p++;
+      } else if(*p == '$' && p + 1 < end && p[1] == delim) {
+        entry->anchored = 1;
+        p++;
+        continue;
+      }
+      entry->pattern[n++] = *p++;
+    }
+    entry->pattern[n] = '\0';
+  } else {
+    entry->line = atoi(p);
+  }
+
+  // exuberant / universal ctags add a line: extension field
+  const char *field = address;
+  while((field = memchr(field, '\t', end - field)) != NULL) {
+    field++;
+    if(end - field > 5 && strncmp(field, "line:", 5) == 0) {
+      entry->line = atoi(field + 5);
+      break;
+    }
+  }
+}
+
+/** ctags **/
+
+int ctagsFind(const char *filename, char *path, size_t pathcap) {
+  char dir[PATH_MAX];
+  if(filename == NULL || realpath(filename, dir) == NULL) {
+    if(getcwd(dir, sizeof(dir)) == NULL) {
+      return -1;
+    }
+  } else {
+    char *slash = strrchr(dir, '/');
+    *slash = '\0';
+  }
+
+  while(1) {
+    snprintf(path, pathcap, "%s/tags", dir);
+    if(access(path, R_OK) == 0) {
+      return 0;
+    }
+
+    char *slash = strrchr(dir, '/');
+    if(slash == NULL || dir[0] == '\0') {
+      return -1;
+    }
+    *slash = '\0';
+  }
+}
+
+int ctagsLookup(const char *tagspath, const char *name, int nth, struct ctagsEntry *entry) {
+  int fd = open(tagspath, O_RDONLY);
+  if(fd == -1) {
+    return -1;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) == -1 || st.st_size == 0) {
+    close(fd);
+    return -1;
+  }
+
+  char *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED) {
+    return -1;
+  }
+  madvise(data, st.st_size, MADV_RANDOM);
+
+  size_t len = st.st_size;
+  size_t namelen = strlen(name);
+  char key[256];
+  if(namelen + 1 >= sizeof(key)) {
+    munmap(data, len);
+    return -1;
+  }
+  memcpy(key, name, namelen);
+  key[namelen] = '\t';
+
+  // tags for one name are adjacent in a sorted file; anything else has
+  // to be scanned
+  size_t pos = 0;
+  int sorted = ctagsSortMode(data, len) == 1;
+  if(sorted) {
+    pos = sortedSeekLower(data, len, key, namelen + 1);
+  }
+
+  int found = -1;
+  entry->matches = 0;
+  while(pos < len) {
+    const char *end = ctagsLineEnd(data, len, pos);
+    if((size_t) (end - &data[pos]) > namelen && memcmp(&data[pos], key, namelen + 1) == 0) {
+      if(entry->matches == nth) {
+        ctagsParse(tagspath, &data[pos], end, entry);
+        found = 0;
+      }
+      entry->matches++;
+    } else if(sorted) {
+      break;
+    }
+    pos = end - data + 1;
+  }
+
+  munmap(data, len);
+  return found;
+}
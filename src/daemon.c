@@ -0,0 +1,523 @@
+/*
+* daemon.c
+*
+* The editing daemon, its per-terminal sessions and the attach client
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "daemon.h"
+#include "editor.h"
+#include "alloc.h"
+#include "trace.h"
+
+/** data **/
+
+// sent by the client, with its terminal attached as SCM_RIGHTS
+struct daemonRequest {
+  char magic[8]; // DAEMON_MAGIC
+  char path[PATH_MAX]; // absolute path to show, empty for the last buffer shown
+};
+
+struct daemonSession {
+  int sock; // connection to the client, closed when the session ends
+  int tty; // the client's terminal
+  int wake[2]; // written to when another terminal changed the shown buffer
+  int raw; // tty is in raw mode, orig holds its settings
+  struct termios orig;
+  int quit;
+
+  // this terminal's view, swapped into the shown buffer whenever the
+  // session holds the editor
+  struct editorConfig *state;
+  int cx;
+  int cy;
+  int rx;
+  int rowoff;
+  int coloff;
+  int screenrows;
+  int screencols;
+  char statusmsg[80];
+  time_t statusmsg_time;
+
+  struct daemonSession *next;
+};
+
+// held while running editor code; a session lets go of it while waiting
+// for its terminal
+static pthread_mutex_t daemonLock = PTHREAD_MUTEX_INITIALIZER;
+static struct daemonSession *daemonSessions = NULL;
+
+/** sessions **/
+
+static void daemonSave(struct daemonSession *s) {
+  // other sessions' budget runs must not evict the buffer this one shows
+  if(s->state != editorState) {
+    if(s->state) {
+      s->state->viewers--;
+    }
+    editorState->viewers++;
+  }
+  s->state = editorState;
+  s->cx = E.cx;
+  s->cy = E.cy;
+  s->rx = E.rx;
+  s->rowoff = E.rowoff;
+  s->coloff = E.coloff;
+  s->screenrows = E.screenrows;
+  s->screencols = E.screencols;
+  memcpy(s->statusmsg, E.statusmsg, sizeof(s->statusmsg));
+  s->statusmsg_time = E.statusmsg_time;
+}
+
+static void daemonRestore(struct daemonSession *s) {
+  editorState = s->state;
+  E.cx = s->cx;
+  E.cy = s->cy;
+  E.rx = s->rx;
+  E.rowoff = s->rowoff;
+  E.coloff = s->coloff;
+  E.screenrows = s->screenrows;
+  E.screencols = s->screencols;
+  memcpy(E.statusmsg, s->statusmsg, sizeof(E.statusmsg));
+  E.statusmsg_time = s->statusmsg_time;
+  E.ttyin = s->tty;
+  E.ttyout = s->tty;
+  E.session = s;
+
+  // another terminal may have evicted the buffer or deleted rows under
+  // the cursor meanwhile
+  editorBufferRestore();
+  if(E.cy > E.numrows) {
+    E.cy = E.numrows;
+  }
+  int size = E.cy < E.numrows ? E.row[E.cy].size : 0;
+  if(E.cx > size) {
+    E.cx = size;
+  }
+}
+
+static void daemonRelease(struct daemonSession *s) {
+  daemonSave(s);
+  pthread_mutex_unlock(&daemonLock);
+}
+
+static void daemonAcquire(struct daemonSession *s) {
+  pthread_mutex_lock(&daemonLock);
+  daemonRestore(s);
+}
+
+// repaint the other terminals showing the buffer this one just changed
+static void daemonNotify(struct daemonSession *from) {
+  struct daemonSession *s;
+  for(s = daemonSessions; s; s = s->next) {
+    if(s != from && s->state == editorState) {
+      write(s->wake[1], "r", 1);
+    }
+  }
+}
+
+// give the terminal back and drop the session, reporting err to the
+// client if there is one. Called with the lock held, returns without it
+static void daemonEnd(struct daemonSession *s, const char *err) {
+  if(s->raw) {
+    editorWrite("\x1b[2J", 4);
+    editorWrite("\x1b[H", 3);
+    tcsetattr(s->tty, TCSAFLUSH, &s->orig);
+  }
+
+  struct daemonSession **p;
+  for(p = &daemonSessions; *p; p = &(*p)->next) {
+    if(*p == s) {
+      *p = s->next;
+      break;
+    }
+  }
+  if(E.session == s) {
+    E.session = NULL;
+    E.ttyin = -1;
+    E.ttyout = -1;
+  }
+  if(s->state) {
+    s->state->viewers--;
+  }
+  pthread_mutex_unlock(&daemonLock);
+
+  if(err) {
+    write(s->sock, err, strlen(err));
+  }
+  close(s->sock);
+  close(s->tty);
+  close(s->wake[0]);
+  close(s->wake[1]);
+  ALLOC_FREE(ALLOC_UI, s);
+}
+
+// switch this thread to the buffer for path, loading it if it isn't
+// open and reloading it if it changed on disk while it had no edits
+static int daemonShow(const char *path) {
+  if(path[0] == '\0') {
+    editorBufferSwitch(editorBufferRecent());
+    return 0;
+  }
+
+  if(editorBufferOpen(path) == -1) {
+    return -1;
+  }
+  struct stat st;
+  if(!E.dirty && stat(path, &st) == 0 && editorStatTime(&st) != E.mtime) {
+    editorCloseFile();
+    return editorLoad(path);
+  }
+  return 0;
+}
+
+static int daemonReceive(struct daemonSession *s, struct daemonRequest *req) {
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(int))];
+  } ctrl;
+  struct iovec iov = {req, sizeof(*req)};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+
+  ssize_t n = recvmsg(s->sock, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+  struct cmsghdr *c = n > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+  if(c && c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+    memcpy(&s->tty, CMSG_DATA(c), sizeof(int));
+  }
+
+  if(n != sizeof(*req) || memcmp(req->magic, DAEMON_MAGIC, sizeof(DAEMON_MAGIC)) != 0 ||
+      s->tty == -1 || !isatty(s->tty)) {
+    return -1;
+  }
+  req->path[sizeof(req->path) - 1] = '\0';
+  return 0;
+}
+
+static void *daemonSessionRun(void *arg) {
+  struct daemonSession *s = arg;
+  struct daemonRequest req;
+  traceThreadName("session");
+
+  if(daemonReceive(s, &req) == -1) {
+    pthread_mutex_lock(&daemonLock);
+    daemonEnd(s, "bad attach request");
+    return NULL;
+  }
+
+  pthread_mutex_lock(&daemonLock);
+  if(daemonShow(req.path) == -1) {
+    char err[PATH_MAX + 64];
+    snprintf(err, sizeof(err), "can't open %s: %s", req.path, strerror(errno));
+    daemonEnd(s, err);
+    return NULL;
+  }
+  if(editorRawMode(s->tty, &s->orig) == -1) {
+    daemonEnd(s, "can't put the terminal in raw mode");
+    return NULL;
+  }
+  s->raw = 1;
+
+  // start from where the buffer was last viewed, sized to this terminal
+  daemonSave(s);
+  struct winsize ws;
+  if(ioctl(s->tty, TIOCGWINSZ, &ws) == -1 || ws.ws_row < 3 || ws.ws_col == 0) {
+    ws.ws_row = 24;
+    ws.ws_col = 80;
+  }
+  s->screenrows = ws.ws_row - 2;
+  s->screencols = ws.ws_col;
+  s->next = daemonSessions;
+  daemonSessions = s;
+  daemonRestore(s);
+  editorSetStatusMessage("Attached, %d buffer(s) open | ^Q detach | ^E open | ^N/^W buffers",
+    editorBufferCount());
+
+  while(!s->quit) {
+    editorScreenRefresh();
+    long long dirty = E.dirty;
+    editorProcessKeypress();
+    if(E.dirty != dirty) {
+      daemonNotify(s);
+    }
+  }
+
+  daemonEnd(s, NULL);
+  return NULL;
+}
+
+/** editor hooks **/
+
+// runs background work a slice at a time and repaints when another
+// terminal changed the buffer, holding the editor only in between
+void daemonWait(struct daemonSession *s) {
+  int pending = IDLE_PENDING;
+  while(1) {
+    struct pollfd pfd[2] = {{s->tty, POLLIN, 0}, {s->wake[0], POLLIN, 0}};
+    daemonRelease(s);
+    int n = poll(pfd, 2, (pending & IDLE_PENDING) ? 0 : -1);
+    daemonAcquire(s);
+
+    if((n == -1 && errno != EINTR) || (pfd[0].revents & (POLLHUP | POLLERR | POLLNVAL))) {
+      daemonHangup(s);
+    }
+    if(pfd[0].revents & POLLIN) {
+      return;
+    }
+    if(pfd[1].revents & POLLIN) {
+      char drain[64];
+      while(read(s->wake[0], drain, sizeof(drain)) > 0);
+      editorScreenRefresh();
+    }
+    if(n == 0) {
+      pending = editorIdle();
+      if(pending & IDLE_REPAINT) {
+        editorScreenRefresh();
+      }
+    }
+  }
+}
+
+void daemonDetach(struct daemonSession *s) {
+  s->quit = 1;
+}
+
+void daemonHangup(struct daemonSession *s) {
+  s->raw = 0; // nothing left to restore
+  daemonEnd(s, NULL);
+  pthread_exit(NULL);
+}
+
+/** server **/
+
+int daemonSocketPath(char *buf, size_t bufsize) {
+  const char *dir = getenv("XDG_RUNTIME_DIR");
+  if(dir && *dir) {
+    snprintf(buf, bufsize, "%s/conchpad.sock", dir);
+    return 0;
+  }
+
+  char priv[64];
+  snprintf(priv, sizeof(priv), "/tmp/conchpad-%d", (int) getuid());
+  snprintf(buf, bufsize, "%s/conchpad.sock", priv);
+  if(mkdir(priv, 0700) == -1 && errno != EEXIST) {
+    return -1;
+  }
+
+  // anyone can create it first in /tmp, so only trust a real directory
+  // of ours that nobody else can get into
+  struct stat st;
+  if(lstat(priv, &st) == -1) {
+    return -1;
+  }
+  if(!S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 077)) {
+    errno = EACCES;
+    return -1;
+  }
+  return 0;
+}
+
+int daemonServe(const char *path, char **files, int nfiles) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "socket path too long: %s\n", path);
+    return 1;
+  }
+  strcpy(addr.sun_path, path);
+
+  // a socket nobody answers on was left behind by a daemon that died
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd == -1) {
+    perror("socket");
+    return 1;
+  }
+  if(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+    fprintf(stderr, "a daemon is already listening on %s\n", path);
+    close(fd);
+    return 1;
+  }
+  close(fd);
+
+  // only ever replace a stale socket, never a file given by mistake
+  struct stat st;
+  if(lstat(path, &st) == 0) {
+    if(!S_ISSOCK(st.st_mode)) {
+      fprintf(stderr, "%s exists and is not a socket\n", path);
+      return 1;
+    }
+    unlink(path);
+  }
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  mode_t mask = umask(0177); // only the owner may connect
+  int bound = bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+  umask(mask);
+  if(bound == -1 || listen(fd, 16) == -1) {
+    perror(path);
+    return 1;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  editorInitState();
+  editorBufferRegister();
+  E.ttyin = -1;
+  E.ttyout = -1;
+
+  // by absolute path, which is how clients ask for them
+  int j;
+  for(j = 0; j < nfiles; j++) {
+    char full[PATH_MAX];
+    if(realpath(files[j], full) == NULL || editorBufferOpen(full) == -1) {
+      perror(files[j]);
+    }
+  }
+  fprintf(stderr, "ConchPad daemon listening on %s\n", path);
+
+  while(1) {
+    int c = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+    if(c == -1) {
+      if(errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      perror("accept");
+      return 1;
+    }
+
+    struct ucred cred;
+    socklen_t credlen = sizeof(cred);
+    if(getsockopt(c, SOL_SOCKET, SO_PEERCRED, &cred, &credlen) == -1 || cred.uid != getuid()) {
+      close(c);
+      continue;
+    }
+    struct timeval timeout = {5, 0}; // for the request, not the session
+    setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct daemonSession *s = ALLOC_CALLOC(ALLOC_UI, 1, sizeof(*s));
+    if(s == NULL) {
+      close(c);
+      continue;
+    }
+    s->sock = c;
+    s->tty = -1;
+    if(pipe2(s->wake, O_NONBLOCK | O_CLOEXEC) == -1) {
+      close(c);
+      ALLOC_FREE(ALLOC_UI, s);
+      continue;
+    }
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if(pthread_create(&thread, &attr, daemonSessionRun, s) != 0) {
+      pthread_mutex_lock(&daemonLock);
+      daemonEnd(s, "out of threads");
+    }
+    pthread_attr_destroy(&attr);
+  }
+}
+
+/** client **/
+
+int daemonAttach(const char *path, const char *filename) {
+  struct daemonRequest req;
+  memset(&req, 0, sizeof(req));
+  memcpy(req.magic, DAEMON_MAGIC, sizeof(DAEMON_MAGIC));
+  if(!isatty(STDIN_FILENO) || (filename && realpath(filename, req.path) == NULL)) {
+    return -1;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd == -1 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+    if(fd != -1) {
+      close(fd);
+    }
+    return -1;
+  }
+
+  // the terminal only goes to a daemon run by this user
+  struct ucred cred;
+  socklen_t credlen = sizeof(cred);
+  if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &credlen) == -1 || cred.uid != getuid()) {
+    fprintf(stderr, "ConchPad: %s belongs to another user, not attaching\n", path);
+    close(fd);
+    return 1;
+  }
+
+  union {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(int))];
+  } ctrl;
+  memset(&ctrl, 0, sizeof(ctrl));
+  struct iovec iov = {&req, sizeof(req)};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+  struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+  c->cmsg_level = SOL_SOCKET;
+  c->cmsg_type = SCM_RIGHTS;
+  c->cmsg_len = CMSG_LEN(sizeof(int));
+  int tty = STDIN_FILENO;
+  memcpy(CMSG_DATA(c), &tty, sizeof(int));
+
+  if(sendmsg(fd, &msg, 0) != sizeof(req)) {
+    close(fd);
+    return -1;
+  }
+
+  // the daemon has the terminal now; it closes the connection when the
+  // user detaches, saying why if the session couldn't start
+  char reply[PATH_MAX + 64];
+  size_t got = 0;
+  ssize_t n;
+  while((n = read(fd, &reply[got], sizeof(reply) - 1 - got)) != 0) {
+    if(n > 0) {
+      got += n;
+    } else if(errno != EINTR) {
+      break;
+    }
+  }
+  close(fd);
+
+  if(got) {
+    reply[got] = '\0';
+    fprintf(stderr, "ConchPad: %s\n", reply);
+    return 1;
+  }
+  return 0;
+}
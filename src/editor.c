@@ -0,0 +1,3356 @@
+/*
+* editor.c
+*
+* The editor core: rows, file i/o, rendering, input handling and the
+* background tasks. main.c only parses arguments and runs the loop
+*
+* Author: Kyle Sherman
+* Created: 2025-08-05
+*/
+
+/** includes **/
+
+// even though these are defines, some of our includes rely on them to determine what features to expose
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <termios.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include "editor.h"
+#include "lineindex.h"
+#include "sortedseek.h"
+#include "timestamp.h"
+#include "syntax.h"
+#include "bracketindex.h"
+#include "ctags.h"
+#include "vscreen.h"
+#include "cellgrid.h"
+#include "hdrhist.h"
+#include "keyscript.h"
+#include "trace.h"
+#include "alloc.h"
+#include "probes.h"
+#include "profile.h"
+#include "daemon.h"
+
+/** data **/
+
+// the terminal editor's own state; libconchpad buffers bring their own
+static struct editorConfig editorMain;
+__thread struct editorConfig *editorState = &editorMain;
+
+/** latency **/
+
+// every key is stamped when it is read and again once the frame showing
+// its effect has been written out, so the histograms measure what the
+// user actually waits for
+
+long long editorNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void editorLatencyInit() {
+  hdrInit(&E.latency.key);
+  hdrInit(&E.latency.frame);
+  hdrInit(&E.latency.bytes);
+  E.latency.key_ns = 0;
+  E.latency.overlay = 0;
+}
+
+// a frame started at start has just been written
+void editorLatencyFrame(long long start, int bytes) {
+  long long now = editorNow();
+  hdrRecord(&E.latency.frame, now - start);
+  hdrRecord(&E.latency.bytes, bytes);
+  if(E.latency.key_ns) {
+    hdrRecord(&E.latency.key, now - E.latency.key_ns);
+    E.latency.key_ns = 0;
+  }
+}
+
+// nanoseconds as a short human readable duration
+void editorFormatNs(long long ns, char *buf, size_t bufsize) {
+  if(ns < 1000000) {
+    snprintf(buf, bufsize, "%lldus", ns / 1000);
+  } else {
+    snprintf(buf, bufsize, "%.1fms", ns / 1e6);
+  }
+}
+
+int editorLatencySummary(char *buf, size_t bufsize) {
+  char k50[16], k99[16], f50[16], f99[16];
+  editorFormatNs(hdrPercentile(&E.latency.key, 50), k50, sizeof(k50));
+  editorFormatNs(hdrPercentile(&E.latency.key, 99), k99, sizeof(k99));
+  editorFormatNs(hdrPercentile(&E.latency.frame, 50), f50, sizeof(f50));
+  editorFormatNs(hdrPercentile(&E.latency.frame, 99), f99, sizeof(f99));
+  return snprintf(buf, bufsize, "key %s/%s frame %s/%s %lldB", k50, k99, f50, f99,
+    hdrPercentile(&E.latency.bytes, 50));
+}
+
+void editorLatencyWrite(FILE *fp) {
+  hdrDump(&E.latency.key, fp, "key_to_paint_us", 1000.0);
+  hdrDump(&E.latency.frame, fp, "frame_render_us", 1000.0);
+  hdrDump(&E.latency.bytes, fp, "frame_bytes", 1.0);
+}
+
+// atexit handler for --latency
+void editorLatencyDump() {
+  FILE *fp = fopen(E.latency.dump, "w");
+  if(fp == NULL) {
+    return;
+  }
+  editorLatencyWrite(fp);
+  fclose(fp);
+}
+
+/** terminal **/
+
+// all terminal output goes through here so a headless run can capture it
+void editorWrite(const char *buf, size_t len) {
+  if(E.headless.active) {
+    vscreenWrite(&E.headless.screen, buf, len);
+    E.headless.bytes += len;
+    return;
+  }
+  write(E.ttyout, buf, len);
+}
+
+// read one byte of input, from the terminal or the key script. Returns 1
+// when a byte was read
+int editorReadByte(char *c) {
+  if(E.headless.active) {
+    if(E.headless.inputpos >= E.headless.keyend) {
+      return 0;
+    }
+    *c = E.headless.input[E.headless.inputpos++];
+    return 1;
+  }
+  return read(E.ttyin, c, 1);
+}
+
+void die(const char *string) {
+  editorWrite("\x1b[2J", 4);
+  editorWrite("\x1b[H", 3);
+
+  perror(string);
+  exit(1);
+}
+
+// Restore terminal to original attributes upon program exit
+// store termios struct in its original state and set attribute to apply
+void disableRawMode() {
+  if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &E.orig_termios) == -1) {
+    die("tcsetattr");
+  }
+}
+
+// For a text editor, we need to capture raw input. Default terminal behavior
+// is to wait for an enter key; this is called canonical mode (cooked mode)
+// Disable the following flags in raw mode:
+//  1. ECHO: Echos input to the terminal
+//  2. ICONON: Read input byte-by-byte instead of line-by-line
+//  3. ISIG: Disable the default ctrl-c and ctrl-z signals
+//  4. IXON: Disables CTRL-S & CTRL-Q used for software flow control
+//  5. IEXTEN: Disable CTRL-V - causes system to wait for another character input
+//  6. ICRNL: Disable CTRL-M - interprets carriage returns as newline characters
+//  7. OPOST: disable all output processing features (i.e. \n -> \r\n)
+int editorRawMode(int fd, struct termios *orig) {
+  if(tcgetattr(fd, orig) == -1) {
+    return -1;
+  }
+
+  struct termios raw = *orig;
+  raw.c_lflag &= ~(ECHO); // disable the ECHO flag - printing keystrokes back
+  raw.c_lflag &= ~(ICANON); // disable canonical flag
+  raw.c_lflag &= ~(ISIG); // disable (SIGINT & SIGSTP) signals (causes suspend)
+  raw.c_iflag &= ~(IXON); // disable (CTRL-S) and (CTRL-Q)
+  raw.c_lflag &= ~(IEXTEN); // disable (ctrl-v) and ctrl-o (macOS)
+  raw.c_iflag &= ~(ICRNL); // disable ctrl-m (forces ctrl-m to read as 13 [carriage return] instead of 10 [newline])
+  raw.c_oflag &= ~(OPOST); // disable all output processing features
+
+  // these flags are mostly inconsiquential as they are typically turned off by default
+  // tradition holds, that these are a part of 'raw mode' so I want to keep with the standards
+  // even though there should be no noticible effects
+  raw.c_cflag |= (CS8);
+  raw.c_iflag &= ~(BRKINT | INPCK | ISTRIP);
+
+  // configure a few terminal settings
+  // VMIN: number of bytes input needed before read() can return
+  // VTIME: max amount of time to wait before read() returns [in 100 ms intervals]
+  raw.c_cc[VMIN] = 0; // return as soon as any input can be read
+  raw.c_cc[VTIME] = 1; // min value - since we are reading every keystroke, 1 is fine (bash on windows ignores this)
+
+
+  return tcsetattr(fd, TCSAFLUSH, &raw);
+}
+
+void enableRawMode() {
+  if(editorRawMode(STDIN_FILENO, &E.orig_termios) == -1) {
+    die("tcsetattr");
+  }
+  atexit(disableRawMode); // execute at program exit
+}
+
+// turn the first byte of a keypress, plus whatever escape sequence
+// follows it, into a key
+int editorDecodeKey(char input) {
+  if (input == '\x1b') {
+    char seq[3];
+
+    if(editorReadByte(&seq[0]) != 1) {
+      return '\x1b';
+    }
+
+    if(editorReadByte(&seq[1]) != 1) {
+      return '\x1b';
+    }
+
+    if (seq[0] == '[') {
+      if (seq[1] >= '0' && seq[1] <= '9') {
+        if(editorReadByte(&seq[2]) != 1) {
+          return '\x1b';
+        }
+
+        if(seq[2] == '~') {
+          switch (seq[1]) {
+            case '1': return HOME_KEY;
+            case '3': return DEL_KEY;
+            case '4': return END_KEY;
+            case '5': return PAGE_UP;
+            case '6': return PAGE_DOWN;
+            case '7': return HOME_KEY;
+            case '8': return END_KEY;
+          }
+        }
+      } else {
+        switch (seq[1]) {
+          case 'A': return ARROW_UP;
+          case 'B': return ARROW_DOWN;
+          case 'C': return ARROW_RIGHT;
+          case 'D': return ARROW_LEFT;
+          case 'H': return HOME_KEY;
+          case 'F': return END_KEY;
+      }
+    }
+  } else if (seq[0] == '0') {
+    switch (seq[1]) {
+      case 'H': return HOME_KEY;
+      case 'F': return END_KEY;
+    }
+  }
+    return '\x1b';
+  } else {
+    return input;
+  }
+}
+
+// wait for one keypress and return it
+int editorReadKey() {
+  int nread;
+  char input;
+
+  if(E.headless.active) {
+    // a script never waits, so give background work one slice per key
+    // to keep runs reproducible. Running out of keys backs out of any
+    // prompt and ends the run
+    if(E.headless.inputpos >= E.headless.inputlen) {
+      E.headless.quit = 1;
+      return '\x1b';
+    }
+    // a bare escape must not swallow the keys typed after it
+    E.headless.keyend = E.headless.inputpos + keyScriptNext(&E.headless.input[E.headless.inputpos],
+      E.headless.inputlen - E.headless.inputpos);
+    editorIdle();
+  } else if(E.session) {
+    daemonWait(E.session);
+  } else {
+    // while background work is queued, only block for input once it is done
+    struct pollfd pfd = { E.ttyin, POLLIN, 0 };
+    int pending = IDLE_PENDING;
+    while((pending & IDLE_PENDING) && poll(&pfd, 1, 0) == 0) {
+      pending = editorIdle();
+      if(pending & IDLE_REPAINT) {
+        editorScreenRefresh();
+      }
+    }
+  }
+  E.headless.keys++;
+
+  while((nread = editorReadByte(&input)) != 1) {
+    if (nread == -1 && errno != EAGAIN && errno != EINTR) {
+      if(E.session) {
+        daemonHangup(E.session);
+      }
+      die("read");
+    }
+  }
+  E.latency.key_ns = editorNow();
+
+  TRACE_BEGIN("key read");
+  int key = editorDecodeKey(input);
+  TRACE_END("key read");
+  PROBE1(key, key);
+  return key;
+}
+
+// use device status report to query the terminal for status information
+// providing an argument of 6 to the n command we can read from the stdin
+// source: https://vt100.net/docs/vt100-ug/chapter3.html#CPR
+int getCursorPosition(int *rows, int *cols) {
+  char buf[32];
+  unsigned int i = 0;
+
+  if(write(E.ttyout, "\x1b[6n", 4) != 4) {
+    return -1;
+  }
+
+  while(i < sizeof(buf) - 1) {
+    if(read(E.ttyin, &buf[i], 1) != 1) {
+      break;
+    }
+    if(buf[i] == 'R') {
+      break;
+    }
+
+    i++;
+  }
+
+  if (buf[0] != '\x1b' || buf[1] != '[') return -1;
+  if (sscanf(&buf[2], "%d;%d", rows, cols) != 2) return -1;
+
+  return 0;
+}
+
+// uses system function and struct winsize from sys/ioctl.h
+// returns -1 on fail
+// on success returns a struct containing number of rows and columns
+int getWindowSize(int *rows, int *cols) {
+  struct winsize ws;
+
+  if(ioctl(E.ttyout, TIOCGWINSZ, &ws) == -1 || ws.ws_col == 0) {
+    if(write(E.ttyout, "\x1b[999C\x1b[999B", 12) != 12) {
+      return -1;
+    }
+    return getCursorPosition(rows, cols);
+  } else {
+    *cols = ws.ws_col;
+    *rows = ws.ws_row;
+    return 0;
+  }
+}
+
+/** line index **/
+
+long long editorIndexRowLen(int i, void *ctx) {
+  (void) ctx;
+  return E.row[i].size + 1; // every row is written back with a trailing newline
+}
+
+// row inserts / deletes shift every later row so the tree is rebuilt lazily
+// the next time someone needs all of it. Character edits only touch one
+// row and can be applied in O(log n)
+void editorIndexEnsure() {
+  if(!E.lineidx.valid || E.lineidx.n != E.numrows) {
+    lineIndexBuild(&E.lineidx, E.numrows, editorIndexRowLen, NULL);
+  }
+}
+
+void editorIndexRowResized(erow *row, int delta) {
+  if(row->idx < E.lineidx.upto) {
+    lineIndexAdd(&E.lineidx, row->idx, delta);
+  }
+}
+
+// byte offset of the cursor from the start of the file. The status bar
+// asks every frame, so after a row insert / delete the rows above it come
+// from the stale index and only the few below are summed by hand
+long long editorCursorOffset() {
+  int from = E.lineidx.upto;
+  if(E.cy - from > ConchPad_INDEX_WALK) {
+    editorIndexEnsure();
+    from = E.lineidx.upto;
+  }
+  if(from > E.cy) {
+    from = E.cy;
+  }
+
+  long long offset = lineIndexPrefix(&E.lineidx, from);
+  for(; from < E.cy; from++) {
+    offset += editorIndexRowLen(from, NULL);
+  }
+  if(E.cy < E.numrows) {
+    offset += E.cx;
+  }
+  return offset;
+}
+
+// move the cursor to the byte offset, clamping to the file
+void editorGotoOffset(long long offset) {
+  editorIndexEnsure();
+  if(E.numrows == 0) {
+    return;
+  }
+
+  long long total = lineIndexTotal(&E.lineidx);
+  if(offset >= total) {
+    offset = total - 1;
+  }
+  if(offset < 0) {
+    offset = 0;
+  }
+
+  E.cy = lineIndexFind(&E.lineidx, offset);
+  E.cx = offset - lineIndexPrefix(&E.lineidx, E.cy);
+  if(E.cx > E.row[E.cy].size) {
+    E.cx = E.row[E.cy].size;
+  }
+}
+
+/** time index **/
+
+void editorTimeIndexReset() {
+  E.timeidx.fmt = TS_NONE;
+  E.timeidx.count = 0;
+  E.timeidx.next = 0;
+  E.timeidx.done = 0;
+}
+
+// the index is sampled and every lookup finishes with a local scan, so
+// row inserts / deletes only need to keep the sample rows pointing at the
+// right place rather than forcing a rebuild
+void editorTimeIndexShift(int at, int delta) {
+  int j;
+  for(j = 0; j < E.timeidx.count; j++) {
+    if(E.timeidx.rows[j] > at || (delta > 0 && E.timeidx.rows[j] == at)) {
+      E.timeidx.rows[j] += delta;
+    }
+    if(E.timeidx.rows[j] >= E.numrows) {
+      E.timeidx.rows[j] = E.numrows ? E.numrows - 1 : 0;
+    }
+  }
+
+  if(E.timeidx.next > at) {
+    E.timeidx.next += delta;
+  }
+}
+
+// timestamp of a row, -1 if the row doesn't start with one
+int editorRowTime(int at, long long *t) {
+  if(E.timeidx.fmt == TS_NONE || at < 0 || at >= E.numrows) {
+    return -1;
+  }
+  return tsParse(E.timeidx.fmt, E.row[at].chars, E.row[at].size, t);
+}
+
+// look at the first rows of the file and pick the format that most of
+// them start with. Logs often mix in continuation lines, so a single
+// match is not enough
+void editorTimeIndexDetect() {
+  int votes[TS_EPOCH + 1] = {0};
+  int j;
+  for(j = 0; j < E.numrows && j < 100; j++) {
+    votes[tsDetect(E.row[j].chars, E.row[j].size)]++;
+  }
+
+  int best = TS_NONE;
+  int fmt;
+  for(fmt = TS_ISO; fmt <= TS_EPOCH; fmt++) {
+    if(votes[fmt] > votes[best] || (best == TS_NONE && votes[fmt] > 0)) {
+      best = fmt;
+    }
+  }
+
+  E.timeidx.fmt = best;
+}
+
+// take up to ConchPad_TIME_SLICE samples
+int editorTimeIndexIdle() {
+  struct timeIndex *ti = &E.timeidx;
+  if(ti->done) {
+    return 0;
+  }
+
+  if(ti->fmt == TS_NONE) {
+    editorTimeIndexDetect();
+    if(ti->fmt == TS_NONE) {
+      ti->done = 1;
+      return 0;
+    }
+  }
+
+  int samples = 0;
+  while(ti->next < E.numrows && samples < ConchPad_TIME_SLICE) {
+    // the first row at or after the sample point that has a timestamp
+    long long t;
+    int at = ti->next;
+    int limit = at + ConchPad_TIME_SAMPLE;
+    while(at < E.numrows && at < limit && editorRowTime(at, &t) != 0) {
+      at++;
+    }
+
+    if(at < E.numrows && at < limit) {
+      if(ti->count == ti->cap) {
+        int newcap = ti->cap ? ti->cap * 2 : 1024;
+        long long *times = ALLOC_REALLOC(ALLOC_INDEX, ti->times, sizeof(long long) * newcap);
+        int *rows = ALLOC_REALLOC(ALLOC_INDEX, ti->rows, sizeof(int) * newcap);
+        if(times) ti->times = times;
+        if(rows) ti->rows = rows;
+        if(times == NULL || rows == NULL) {
+          ti->done = 1;
+          return 0;
+        }
+        ti->cap = newcap;
+      }
+      ti->times[ti->count] = t;
+      ti->rows[ti->count] = at;
+      ti->count++;
+    }
+
+    ti->next = limit;
+    samples++;
+  }
+
+  if(ti->next >= E.numrows) {
+    ti->done = 1;
+  }
+  return ti->done ? 0 : IDLE_PENDING;
+}
+
+// binary search the samples for the last one before the target, then scan
+// forward to the first row whose timestamp is >= target
+int editorTimeIndexFind(long long target) {
+  struct timeIndex *ti = &E.timeidx;
+  while(!ti->done) {
+    editorTimeIndexIdle();
+  }
+
+  int lo = 0;
+  int hi = ti->count;
+  while(lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if(ti->times[mid] < target) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  int at = lo > 0 ? ti->rows[lo - 1] : 0;
+  long long t;
+  for(; at < E.numrows; at++) {
+    if(editorRowTime(at, &t) == 0 && t >= target) {
+      return at;
+    }
+  }
+
+  return -1;
+}
+
+// the closest timestamp at or above the cursor, used as the reference for
+// relative jumps and for the status bar
+int editorCursorTime(long long *t) {
+  int at;
+  for(at = E.cy; at >= 0 && E.cy - at < ConchPad_TIME_SAMPLE; at--) {
+    if(editorRowTime(at, t) == 0) {
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/** bracket matching **/
+
+// every row keeps a depth summary per bracket kind, folded into a segment
+// tree so the partner of a bracket can be found in O(log n) whatever the
+// distance. Brackets the highlighter put in a string or comment don't
+// count; rows it hasn't reached yet count every bracket until they are lexed
+
+static const char bracket_opens[] = "([{";
+static const char bracket_closes[] = ")]}";
+
+// bracket kind at render column i, or -1. *dir is 1 for an open, -1 for a close
+int editorBracketAt(erow *row, int i, int *dir) {
+  if(i < 0 || i >= row->rsize || row->render[i] == '\0') {
+    return -1;
+  }
+
+  if(row->hl_instate >= 0 && (row->hl[i] == HL_STRING ||
+      row->hl[i] == HL_COMMENT || row->hl[i] == HL_MLCOMMENT)) {
+    return -1;
+  }
+
+  char *p = strchr(bracket_opens, row->render[i]);
+  if(p) {
+    *dir = 1;
+    return p - bracket_opens;
+  }
+  p = strchr(bracket_closes, row->render[i]);
+  if(p) {
+    *dir = -1;
+    return p - bracket_closes;
+  }
+  return -1;
+}
+
+// recompute a row's summaries from its render and highlight classes
+void editorBracketSummarize(erow *row) {
+  int depth[BRACKET_KINDS] = {0};
+  int k;
+  for(k = 0; k < BRACKET_KINDS; k++) {
+    row->brackets[k].min = 0;
+  }
+
+  int i;
+  for(i = 0; i < row->rsize; i++) {
+    int dir;
+    k = editorBracketAt(row, i, &dir);
+    if(k < 0) {
+      continue;
+    }
+    depth[k] += dir;
+    if(depth[k] < row->brackets[k].min) {
+      row->brackets[k].min = depth[k];
+    }
+  }
+
+  for(k = 0; k < BRACKET_KINDS; k++) {
+    row->brackets[k].delta = depth[k];
+  }
+}
+
+void editorBracketIndexRow(int i, struct bracketSummary *out, void *ctx) {
+  (void) ctx;
+  memcpy(out, E.row[i].brackets, sizeof(E.row[i].brackets));
+}
+
+// like the line index, row inserts / deletes rebuild lazily and single row
+// changes are applied in O(log n)
+void editorBracketEnsure() {
+  if(!E.bracketidx.valid || E.bracketidx.n != E.numrows) {
+    bracketIndexBuild(&E.bracketidx, E.numrows, editorBracketIndexRow, NULL);
+  }
+}
+
+void editorBracketRowChanged(erow *row) {
+  if(E.bracketidx.valid && E.bracketidx.n == E.numrows) {
+    bracketIndexSet(&E.bracketidx, row->idx, row->brackets);
+  }
+}
+
+// find the partner of the bracket at render column rx of row at.
+// Returns 0 and fills *mrow / *mrx when there is one
+int editorBracketMatch(int at, int rx, int *mrow, int *mrx) {
+  if(at < 0 || at >= E.numrows) {
+    return -1;
+  }
+
+  erow *row = &E.row[at];
+  int dir;
+  int kind = editorBracketAt(row, rx, &dir);
+  if(kind < 0) {
+    return -1;
+  }
+
+  // most pairs sit on one row, so look there before touching the tree
+  int depth = 0;
+  int i;
+  for(i = rx; i >= 0 && i < row->rsize; i += dir) {
+    int d;
+    if(editorBracketAt(row, i, &d) == kind) {
+      depth += d * dir;
+      if(depth == 0) {
+        *mrow = at;
+        *mrx = i;
+        return 0;
+      }
+    }
+  }
+
+  // absolute depth at the boundary just before the bracket
+  editorBracketEnsure();
+  int before = bracketIndexPrefix(&E.bracketidx, kind, at);
+  for(i = 0; i < rx; i++) {
+    int d;
+    if(editorBracketAt(row, i, &d) == kind) {
+      before += d;
+    }
+  }
+
+  if(dir > 0) {
+    // the close is the first boundary after the open back at that depth
+    int j = bracketIndexFindNext(&E.bracketidx, kind, at + 1, before);
+    if(j < 0) {
+      return -1;
+    }
+
+    erow *target = &E.row[j];
+    depth = bracketIndexPrefix(&E.bracketidx, kind, j);
+    for(i = 0; i < target->rsize; i++) {
+      int d;
+      if(editorBracketAt(target, i, &d) == kind) {
+        depth += d;
+        if(depth <= before) {
+          *mrow = j;
+          *mrx = i;
+          return 0;
+        }
+      }
+    }
+  } else {
+    // the open follows the last boundary before the close one level up
+    int want = before - 1;
+    int j = bracketIndexFindPrev(&E.bracketidx, kind, at, want);
+    if(j < 0) {
+      return -1;
+    }
+
+    erow *target = &E.row[j];
+    depth = bracketIndexPrefix(&E.bracketidx, kind, j);
+    int last = -1;
+    for(i = 0; i < target->rsize; i++) {
+      int d;
+      if(editorBracketAt(target, i, &d) == kind) {
+        if(d > 0 && depth <= want) {
+          last = i;
+        }
+        depth += d;
+      }
+    }
+
+    if(last >= 0) {
+      *mrow = j;
+      *mrx = last;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+/** outline **/
+
+// rows that define a symbol, in row order. The lexer tags each row it
+// highlights (erow.sym) and the list is patched a row at a time as those
+// tags change, and shifted on row inserts / deletes like the time index,
+// so it is never rebuilt from the whole file
+
+// first entry >= at
+int editorOutlineLower(int at) {
+  int lo = 0;
+  int hi = E.outline.count;
+  while(lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if(E.outline.rows[mid] < at) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+void editorOutlineRowChanged(erow *row) {
+  int i = editorOutlineLower(row->idx);
+  int present = i < E.outline.count && E.outline.rows[i] == row->idx;
+
+  if(row->sym >= 0 && !present) {
+    if(E.outline.count == E.outline.cap) {
+      int cap = E.outline.cap ? E.outline.cap * 2 : 64;
+      int *rows = ALLOC_REALLOC(ALLOC_SYNTAX, E.outline.rows, sizeof(int) * cap);
+      if(rows == NULL) {
+        return;
+      }
+      E.outline.rows = rows;
+      E.outline.cap = cap;
+    }
+    memmove(&E.outline.rows[i + 1], &E.outline.rows[i], sizeof(int) * (E.outline.count - i));
+    E.outline.rows[i] = row->idx;
+    E.outline.count++;
+  } else if(row->sym < 0 && present) {
+    memmove(&E.outline.rows[i], &E.outline.rows[i + 1], sizeof(int) * (E.outline.count - i - 1));
+    E.outline.count--;
+  }
+}
+
+// re-sync rows [start, end) after the worker threads tagged them
+void editorOutlineResync(int start, int end) {
+  int at;
+  for(at = start; at < end; at++) {
+    editorOutlineRowChanged(&E.row[at]);
+  }
+}
+
+// a row was inserted (delta 1) or deleted (delta -1) at row at
+void editorOutlineShift(int at, int delta) {
+  int i = editorOutlineLower(at);
+  if(delta < 0 && i < E.outline.count && E.outline.rows[i] == at) {
+    memmove(&E.outline.rows[i], &E.outline.rows[i + 1], sizeof(int) * (E.outline.count - i - 1));
+    E.outline.count--;
+  }
+  for(; i < E.outline.count; i++) {
+    E.outline.rows[i] += delta;
+  }
+}
+
+// a row was just lexed on the main thread
+void editorRowHighlighted(erow *row) {
+  editorBracketRowChanged(row);
+  editorOutlineRowChanged(row);
+}
+
+/** folding **/
+
+// a folded header hides the fold rows below it. Rows count how many folds
+// hide them, so nested folds survive their parent being opened. A second
+// fenwick tree holds 1 for every shown row and 0 for every hidden one, which
+// turns "row -> screen line" and "screen line -> row" into O(log n) lookups
+// for scrolling, drawing and vertical cursor movement. With nothing folded
+// (the common case) the helpers skip the tree entirely
+
+long long editorFoldRowLen(int i, void *ctx) {
+  (void) ctx;
+  return E.row[i].hidden == 0;
+}
+
+void editorFoldEnsure() {
+  if(!E.foldidx.valid || E.foldidx.n != E.numrows) {
+    lineIndexBuild(&E.foldidx, E.numrows, editorFoldRowLen, NULL);
+  }
+}
+
+// number of shown rows above row at
+int editorVisibleIndex(int at) {
+  if(E.folds == 0) {
+    return at;
+  }
+  editorFoldEnsure();
+  return lineIndexPrefix(&E.foldidx, at);
+}
+
+// the row shown on screen line v, or E.numrows past the last one
+int editorVisibleRow(int v) {
+  if(v < 0) {
+    v = 0;
+  }
+  if(E.folds == 0) {
+    return v < E.numrows ? v : E.numrows;
+  }
+  editorFoldEnsure();
+  if(v >= lineIndexTotal(&E.foldidx)) {
+    return E.numrows;
+  }
+  return lineIndexFind(&E.foldidx, v);
+}
+
+// the shown row after row at. Folds nest, so a shown row's hidden rows
+// are exactly the ones its own fold covers
+int editorNextRow(int at) {
+  if(at >= E.numrows) {
+    return E.numrows;
+  }
+  return at + E.row[at].fold + 1;
+}
+
+// first row past the bottom of the screen
+int editorScreenEnd() {
+  return editorVisibleRow(editorVisibleIndex(E.rowoff) + E.screenrows);
+}
+
+// leading whitespace of a row in render columns, -1 for a blank row
+int editorRowIndent(erow *row) {
+  int i = 0;
+  while(i < row->rsize && row->render[i] == ' ') {
+    i++;
+  }
+  return i < row->rsize ? i : -1;
+}
+
+// rows a fold at row at would hide. A row that leaves a '{' open folds
+// through the row holding its partner; anything else folds the block of
+// deeper indented rows below it (blank rows included, trailing ones not)
+int editorFoldExtent(int at) {
+  erow *row = &E.row[at];
+  if(row->brackets[2].delta > 0) {
+    int i;
+    for(i = row->rsize - 1; i >= 0; i--) {
+      int dir, mrow, mrx;
+      if(editorBracketAt(row, i, &dir) == 2 && dir > 0 &&
+          editorBracketMatch(at, i, &mrow, &mrx) == 0) {
+        if(mrow > at) {
+          return mrow - at;
+        }
+      }
+    }
+  }
+
+  int indent = editorRowIndent(row);
+  if(indent < 0) {
+    return 0;
+  }
+
+  int last = at;
+  int j;
+  for(j = at + 1; j < E.numrows; j++) {
+    int inner = editorRowIndent(&E.row[j]);
+    if(inner >= 0 && inner <= indent) {
+      break;
+    }
+    if(inner >= 0) {
+      last = j;
+    }
+  }
+  return last - at;
+}
+
+// hide rows below a header. A fold swallows any fold it partly overlaps
+// so folds always nest. Callers folding many headers at once can pass
+// update = 0 and let the tree rebuild
+void editorFoldRows(int at, int count, int update) {
+  int j;
+  for(j = at + 1; j <= at + count; j++) {
+    if(j + E.row[j].fold > at + count) {
+      count = j + E.row[j].fold - at;
+    }
+    if(E.row[j].hidden++ == 0 && update && E.foldidx.valid) {
+      lineIndexAdd(&E.foldidx, j, -1);
+    }
+  }
+  E.row[at].fold = count;
+  E.folds++;
+}
+
+void editorUnfoldRow(int at) {
+  int j;
+  for(j = at + 1; j <= at + E.row[at].fold; j++) {
+    if(--E.row[j].hidden == 0 && E.foldidx.valid) {
+      lineIndexAdd(&E.foldidx, j, 1);
+    }
+  }
+  E.row[at].fold = 0;
+  E.folds--;
+}
+
+// open every fold whose hidden rows include row at (and, with header set,
+// a fold headed by row at). Folds nest, so the outermost one is headed by
+// the last shown row above at; opening it exposes the next one in
+void editorUnfoldAround(int at, int header) {
+  if(header && at < E.numrows && E.row[at].fold) {
+    editorUnfoldRow(at);
+  }
+
+  while(E.folds && at > 0) {
+    int v = editorVisibleIndex(at);
+    if(v == 0) {
+      break;
+    }
+    int h = editorVisibleRow(v - 1);
+    if(h >= E.numrows || !E.row[h].fold || h + E.row[h].fold < at) {
+      break;
+    }
+    editorUnfoldRow(h);
+  }
+}
+
+// fold or unfold the row under the cursor
+void editorToggleFold() {
+  if(E.cy >= E.numrows) {
+    return;
+  }
+
+  if(E.row[E.cy].fold) {
+    editorUnfoldRow(E.cy);
+    return;
+  }
+
+  int count = editorFoldExtent(E.cy);
+  if(count == 0) {
+    editorSetStatusMessage("Nothing to fold");
+    return;
+  }
+  editorFoldRows(E.cy, count, 1);
+}
+
+// fold every top level block, or open everything if something is folded
+void editorToggleFoldAll() {
+  int j;
+  if(E.folds) {
+    for(j = 0; j < E.numrows; j++) {
+      E.row[j].fold = 0;
+      E.row[j].hidden = 0;
+    }
+    E.folds = 0;
+    E.foldidx.valid = 0;
+    return;
+  }
+
+  for(j = 0; j < E.numrows; j++) {
+    if(editorRowIndent(&E.row[j]) != 0) {
+      continue;
+    }
+    int count = editorFoldExtent(j);
+    if(count > 0) {
+      editorFoldRows(j, count, 0);
+      j += count;
+    }
+  }
+  E.foldidx.valid = 0;
+
+  // keep the cursor on a shown row
+  while(E.cy < E.numrows && E.row[E.cy].hidden) {
+    E.cy--;
+  }
+  E.cx = 0;
+}
+
+/** syntax highlighting **/
+
+// rows are highlighted lazily: the rows on screen first (just before they
+// are drawn), then everything else from idle time. A row that has never
+// been highlighted draws plain. hl_frontier marks how far the background
+// pass has verified rows against their true incoming state
+
+// add to one of the running totals editorBufferBytes reads. Highlight
+// workers grow rows of the same buffer in parallel, hence the atomic
+void editorRowBytes(long long *total, long long delta) {
+  __atomic_fetch_add(total, delta, __ATOMIC_RELAXED);
+}
+
+// lex a row from instate. Returns 1 if its end state changed
+int editorHighlightRow(erow *row, int instate) {
+  if(row->hl == NULL || row->hlcap < row->rsize) {
+    int cap = row->hlcap && row->rsize < row->hlcap * 2 ? row->hlcap * 2 : row->rsize;
+    cap = cap ? cap : 1;
+    unsigned char *hl = ALLOC_REALLOC(ALLOC_SYNTAX, row->hl, cap);
+    if(hl == NULL) {
+      return 0;
+    }
+    row->hl = hl;
+    editorRowBytes(&E.cachebytes, cap - row->hlcap);
+    row->hlcap = cap;
+  }
+
+  int endstate = syntaxHighlight(E.syntax, row->render, row->rsize, row->hl, instate);
+  row->hl_instate = instate;
+  editorBracketSummarize(row);
+  row->sym = syntaxSymbol(row->render, row->rsize, row->hl, instate, &row->sym_len, &row->sym_kind);
+  if(endstate == row->hl_state) {
+    return 0;
+  }
+
+  row->hl_state = endstate;
+  return 1;
+}
+
+// state flowing into row at, falling back to a plain guess when the row
+// above hasn't been highlighted yet
+int editorRowInState(int at) {
+  if(at == 0 || E.row[at - 1].hl_instate < 0) {
+    return SYN_STATE_NORMAL;
+  }
+  return E.row[at - 1].hl_state;
+}
+
+// re-highlight a row after an edit. If the row's own end state changed,
+// the rows below were lexed from a stale state and have to follow; we stop
+// as soon as a row ends in the state it had cached, so a keystroke usually
+// only touches the row being edited. Rows that were never highlighted are
+// left for the viewport / background passes, and so is a change that
+// spills past the bottom of the screen (e.g. opening a block comment)
+void editorUpdateSyntax(erow *row) {
+  int at = row->idx;
+
+  while(at < E.numrows && E.row[at].hl_instate >= 0) {
+    if(at > row->idx && at >= editorScreenEnd()) {
+      if(at < E.hl_frontier) {
+        E.hl_frontier = at;
+      }
+      break;
+    }
+
+    int changed = editorHighlightRow(&E.row[at], editorRowInState(at));
+    editorRowHighlighted(&E.row[at]);
+    if(!changed) {
+      break;
+    }
+    at++;
+  }
+}
+
+// highlight the rows about to be drawn. Lexing resumes from the nearest
+// highlighted row above the viewport (at most ConchPad_HL_LOOKBACK rows
+// back); past that the state is guessed and the background pass fixes it
+// up later if the guess was wrong
+void editorHighlightViewport() {
+  if(E.syntax == NULL) {
+    return;
+  }
+
+  int first = E.rowoff;
+  int last = editorScreenEnd();
+
+  int at = first;
+  while(at > 0 && first - at < ConchPad_HL_LOOKBACK && E.row[at - 1].hl_instate < 0) {
+    at--;
+  }
+
+  // rows inside folds are left to the background pass
+  for(; at < last; at = at < first ? at + 1 : editorNextRow(at)) {
+    int instate = editorRowInState(at);
+    if(E.row[at].hl_instate != instate) {
+      editorHighlightRow(&E.row[at], instate);
+      editorRowHighlighted(&E.row[at]);
+    }
+  }
+}
+
+// one slice of rows lexed by a worker thread
+struct hlChunk {
+  int start; // first row of the chunk
+  int end; // one past the last row
+  int instate; // state the chunk is lexed from (a guess until verified)
+  int fixup; // re-run: stop once a row's end state stops changing
+  struct editorConfig *state; // buffer the rows belong to
+  pthread_t thread;
+};
+
+// rows are only ever touched by the thread that owns their chunk and the
+// lexer is reentrant, so workers need no locking
+void *editorHighlightChunk(void *arg) {
+  struct hlChunk *chunk = arg;
+  int state = chunk->instate;
+  int at;
+
+  editorState = chunk->state;
+  profileSetPhase(PROFILE_BACKGROUND);
+  traceThreadName("highlight worker");
+  TRACE_BEGIN("highlight chunk");
+  for(at = chunk->start; at < chunk->end; at++) {
+    int changed = editorHighlightRow(&E.row[at], state);
+    if(chunk->fixup && !changed && at > chunk->start) {
+      break;
+    }
+    state = E.row[at].hl_state;
+  }
+  TRACE_END("highlight chunk");
+
+  return NULL;
+}
+
+int editorHighlightThreads() {
+  static int threads = 0;
+  int n = __atomic_load_n(&threads, __ATOMIC_RELAXED);
+  if(n == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n = cpus < 1 ? 1 : cpus > ConchPad_HL_THREADS ? ConchPad_HL_THREADS : cpus;
+    __atomic_store_n(&threads, n, __ATOMIC_RELAXED);
+  }
+  return n;
+}
+
+// lex rows [start, end) with one chunk per core. Every chunk after the
+// first starts from a guessed (plain) state; once all chunks are done,
+// chunks whose real incoming state differs from their guess are re-run
+// from the right state, again in parallel, until every guess checks out.
+// A re-run stops as soon as a row ends in the state it ended in before,
+// so for most languages this converges within a few rows
+void editorHighlightParallel(int start, int end) {
+  struct hlChunk chunks[ConchPad_HL_THREADS];
+  int nchunks = editorHighlightThreads();
+  int per = (end - start + nchunks - 1) / nchunks;
+  int active[ConchPad_HL_THREADS];
+  int j;
+
+  for(j = 0; j < nchunks; j++) {
+    chunks[j].start = start + j * per;
+    chunks[j].end = chunks[j].start + per < end ? chunks[j].start + per : end;
+    chunks[j].instate = j == 0 ? editorRowInState(start) : SYN_STATE_NORMAL;
+    chunks[j].fixup = 0;
+    chunks[j].state = editorState;
+    active[j] = chunks[j].start < chunks[j].end;
+  }
+
+  while(1) {
+    for(j = 0; j < nchunks; j++) {
+      if(active[j] && pthread_create(&chunks[j].thread, NULL,
+          editorHighlightChunk, &chunks[j]) != 0) {
+        editorHighlightChunk(&chunks[j]);
+        active[j] = 0;
+      }
+    }
+    for(j = 0; j < nchunks; j++) {
+      if(active[j]) {
+        pthread_join(chunks[j].thread, NULL);
+      }
+    }
+
+    // check every guess against the state the previous chunk really ended in
+    int rerun = 0;
+    for(j = 1; j < nchunks; j++) {
+      active[j] = 0;
+      if(chunks[j].start >= chunks[j].end) {
+        continue;
+      }
+
+      int instate = E.row[chunks[j].start - 1].hl_state;
+      if(instate != chunks[j].instate) {
+        chunks[j].instate = instate;
+        chunks[j].fixup = 1;
+        active[j] = 1;
+        rerun = 1;
+      }
+    }
+    active[0] = 0;
+
+    if(!rerun) {
+      break;
+    }
+  }
+}
+
+// advance the frontier, re-lexing every row whose incoming state doesn't
+// match the state it was highlighted from. Large untouched stretches
+// (i.e. a freshly opened file) are handed to the worker threads a batch
+// at a time
+int editorHighlightIdle() {
+  if(E.syntax == NULL || E.hl_frontier >= E.numrows) {
+    return 0;
+  }
+
+  if(editorHighlightThreads() > 1 && E.numrows - E.hl_frontier >= ConchPad_HL_BATCH &&
+      E.row[E.hl_frontier].hl_instate < 0) {
+    int start = E.hl_frontier;
+    int end = start + ConchPad_HL_BATCH;
+    TRACE_BEGIN("highlight batch");
+    editorHighlightParallel(start, end);
+    TRACE_END("highlight batch");
+    E.hl_frontier = end;
+    E.bracketidx.valid = 0; // the workers refreshed the row summaries
+    editorOutlineResync(start, end);
+
+    int visible = start < editorScreenEnd() && end > E.rowoff;
+    return IDLE_PENDING | (visible ? IDLE_REPAINT : 0);
+  }
+
+  int screenend = editorScreenEnd();
+  int repaint = 0;
+  int lexed = 0;
+  int visited = 0;
+  while(E.hl_frontier < E.numrows && lexed < ConchPad_HL_SLICE &&
+      visited < ConchPad_HL_SLICE * 64) {
+    int at = E.hl_frontier;
+    int instate = editorRowInState(at);
+    if(E.row[at].hl_instate != instate) {
+      editorHighlightRow(&E.row[at], instate);
+      editorRowHighlighted(&E.row[at]);
+      lexed++;
+      if(at >= E.rowoff && at < screenend && !E.row[at].hidden) {
+        repaint = 1;
+      }
+    }
+    E.hl_frontier++;
+    visited++;
+  }
+
+  return (E.hl_frontier < E.numrows ? IDLE_PENDING : 0) | (repaint ? IDLE_REPAINT : 0);
+}
+
+// forget all highlighting, e.g. when the file type changes
+void editorSelectSyntaxHighlight() {
+  E.syntax = syntaxSelect(E.filename);
+
+  int j;
+  for(j = 0; j < E.numrows; j++) {
+    E.row[j].hl_instate = -1;
+    E.row[j].sym = -1;
+    editorBracketSummarize(&E.row[j]);
+  }
+  E.outline.count = 0;
+  E.hl_frontier = 0;
+  E.bracketidx.valid = 0;
+}
+
+/** row operations **/
+
+int editorRowCxToRx(erow *row, int cx) {
+  int rx = 0;
+  int j;
+  for(j = 0; j < cx; j++) {
+    if(row->chars[j] == '\t') {
+      rx += (ConchPad_TAB_STOP - 1) - (rx % ConchPad_TAB_STOP);
+    }
+
+    rx++;
+  }
+
+  return rx;
+}
+
+int editorRowRxToCx(erow *row, int rx) {
+  int cur_rx = 0;
+  int cx;
+  for(cx = 0; cx < row->size; cx++) {
+    if(row->chars[cx] == '\t') {
+      cur_rx += (ConchPad_TAB_STOP - 1) - (cur_rx % ConchPad_TAB_STOP);
+    }
+    cur_rx++;
+
+    if(cur_rx > rx) {
+      return cx;
+    }
+  }
+
+  return cx;
+}
+
+// expand tabs from chars into render
+int editorRowRender(erow *row) {
+  int tabs = 0;
+  int j;
+  for(j = 0; j < row->size; j++) {
+    if(row->chars[j] == '\t') {
+      tabs++;
+    }
+  }
+
+  // render only ever grows, so retyping a row doesn't reallocate it
+  int need = row->size + tabs * (ConchPad_TAB_STOP - 1) + 1;
+  if(need > row->rcap) {
+    int cap = row->rcap && need < row->rcap * 2 ? row->rcap * 2 : need;
+    char *render = ALLOC_REALLOC(ALLOC_RENDER, row->render, cap);
+    if(render == NULL) {
+      return -1;
+    }
+    row->render = render;
+    editorRowBytes(&E.cachebytes, cap - row->rcap);
+    row->rcap = cap;
+  }
+
+  int idx = 0;
+  for(j = 0; j < row->size; j++) {
+    if(row->chars[j] == '\t') {
+      row->render[idx++] = ' ';
+      while (idx % ConchPad_TAB_STOP != 0) {
+        row->render[idx++] = ' ';
+      }
+    } else {
+      row->render[idx++] = row->chars[j];
+    }
+  }
+
+  row->render[idx] = '\0';
+  row->rsize = idx;
+  return 0;
+}
+
+void editorUpdateRow(erow *row) {
+  if(editorRowRender(row) == -1) {
+    return;
+  }
+
+  editorUpdateSyntax(row);
+  if(row->hl_instate < 0) {
+    editorBracketSummarize(row);
+    editorBracketRowChanged(row);
+  }
+}
+
+void editorInsertRow(int at, char *string, size_t len) {
+  if(at < 0 || at > E.numrows) {
+    return;
+  }
+
+  editorUnfoldAround(at, 0);
+
+  if(E.numrows == E.rowcap) {
+    int cap = E.rowcap ? E.rowcap * 2 : 64;
+    erow *rows = ALLOC_REALLOC(ALLOC_ROWS, E.row, sizeof(erow) * cap);
+    if(rows == NULL) {
+      return;
+    }
+    E.row = rows;
+    E.rowcap = cap;
+  }
+  memmove(&E.row[at + 1], &E.row[at], sizeof(erow) * (E.numrows - at));
+  for(int j = at + 1; j <= E.numrows; j++) {
+    E.row[j].idx++;
+  }
+
+  E.row[at].idx = at;
+  E.row[at].size = len;
+  E.row[at].chars = ALLOC_MALLOC(ALLOC_ROWS, len + 1);
+  E.row[at].cap = len + 1;
+  editorRowBytes(&E.textbytes, len + 1);
+  memcpy(E.row[at].chars, string, len);
+  E.row[at].chars[len] = '\0';
+
+  E.row[at].rsize = 0;
+  E.row[at].rcap = 0;
+  E.row[at].render = NULL;
+  E.row[at].hl = NULL;
+  E.row[at].hlcap = 0;
+  E.row[at].hl_instate = -1;
+  E.row[at].hl_state = SYN_STATE_NORMAL;
+  E.row[at].sym = -1;
+  E.row[at].fold = 0;
+  E.row[at].hidden = 0;
+  if(at < E.hl_frontier) {
+    E.hl_frontier = at;
+  }
+
+  E.numrows++;
+  lineIndexInvalidate(&E.lineidx, at);
+  E.bracketidx.valid = 0;
+  E.foldidx.valid = 0;
+  editorTimeIndexShift(at, 1);
+  editorOutlineShift(at, 1);
+  editorUpdateRow(&E.row[at]);
+  E.dirty++;
+  PROBE2(row_insert, at, len);
+}
+
+void editorFreeRow(erow *row) {
+  editorRowBytes(&E.textbytes, -row->cap);
+  editorRowBytes(&E.cachebytes, -(long long) (row->rcap + row->hlcap));
+  ALLOC_FREE(ALLOC_RENDER, row->render);
+  ALLOC_FREE(ALLOC_ROWS, row->chars);
+  ALLOC_FREE(ALLOC_SYNTAX, row->hl);
+}
+
+// make room for size bytes of text plus the terminating nul, growing
+// geometrically so typing into a row is amortized allocation free
+int editorRowReserve(erow *row, int size) {
+  if(size + 1 <= row->cap) {
+    return 0;
+  }
+
+  int cap = size + 1 < row->cap * 2 ? row->cap * 2 : size + 1;
+  char *chars = ALLOC_REALLOC(ALLOC_ROWS, row->chars, cap);
+  if(chars == NULL) {
+    return -1;
+  }
+  row->chars = chars;
+  editorRowBytes(&E.textbytes, cap - row->cap);
+  row->cap = cap;
+  return 0;
+}
+
+void editorDelRow(int at) {
+  if(at < 0 || at >= E.numrows) {
+    return;
+  }
+
+  PROBE2(row_delete, at, E.row[at].size);
+  editorUnfoldAround(at, 1);
+  editorFreeRow(&E.row[at]);
+  memmove(&E.row[at], &E.row[at + 1], sizeof(erow) * (E.numrows - at - 1));
+  for(int j = at; j < E.numrows - 1; j++) {
+    E.row[j].idx--;
+  }
+  E.numrows--;
+  lineIndexInvalidate(&E.lineidx, at);
+  E.bracketidx.valid = 0;
+  E.foldidx.valid = 0;
+  editorTimeIndexShift(at, -1);
+  editorOutlineShift(at, -1);
+
+  // the row that moved up now follows a different row
+  if(at < E.hl_frontier) {
+    E.hl_frontier = at;
+  }
+  if(at < E.numrows) {
+    editorUpdateSyntax(&E.row[at]);
+  }
+  E.dirty++;
+}
+
+void editorRowInsertChar(erow *row, int at, int c) {
+  if(at < 0 || at > row->size) {
+    at = row->size;
+  }
+
+  if(editorRowReserve(row, row->size + 1) == -1) {
+    return;
+  }
+
+  // I used memmove because it is safe when the src and dest overlap
+  memmove(&row->chars[at + 1], &row->chars[at], row->size - at + 1);
+  row->size++;
+  row->chars[at] = c;
+  editorIndexRowResized(row, 1);
+  editorUpdateRow(row);
+  E.dirty++;
+}
+
+void editorRowAppendString(erow *row, char *string, size_t len) {
+  if(len == 0 || string == NULL) {
+    return;
+  }
+  if(editorRowReserve(row, row->size + len) == -1) {
+    return;
+  }
+  memcpy(&row->chars[row->size], string, len);
+  row->size += len;
+  row->chars[row->size] = '\0';
+  editorIndexRowResized(row, len);
+  editorUpdateRow(row);
+  E.dirty++;
+}
+
+// insert len bytes at column at, for pasting text in one update
+void editorRowInsertString(erow *row, int at, const char *string, size_t len) {
+  if(len == 0) {
+    return;
+  }
+  if(at < 0 || at > row->size) {
+    at = row->size;
+  }
+  if(editorRowReserve(row, row->size + len) == -1) {
+    return;
+  }
+
+  memmove(&row->chars[at + len], &row->chars[at], row->size - at + 1);
+  memcpy(&row->chars[at], string, len);
+  row->size += len;
+  editorIndexRowResized(row, len);
+  editorUpdateRow(row);
+  E.dirty++;
+}
+
+void editorRowDelChar(erow *row, int at) {
+  if(at < 0 || at >= row->size) {
+    return;
+  }
+
+  memmove(&row->chars[at], &row->chars[at + 1], row->size - at);
+  row->size--;
+  editorIndexRowResized(row, -1);
+  editorUpdateRow(row);
+  E.dirty++;
+}
+
+// delete up to len bytes starting at column at
+void editorRowDelString(erow *row, int at, int len) {
+  if(at < 0 || at >= row->size || len <= 0) {
+    return;
+  }
+  if(len > row->size - at) {
+    len = row->size - at;
+  }
+
+  memmove(&row->chars[at], &row->chars[at + len], row->size - at - len + 1);
+  row->size -= len;
+  editorIndexRowResized(row, -len);
+  editorUpdateRow(row);
+  E.dirty++;
+}
+
+void editorDelChar() {
+  if (E.cy == E.numrows) {
+    return;
+  }
+  if(E.cx == 0 && E.cy == 0) {
+    return;
+  }
+
+  erow *row = &E.row[E.cy];
+
+  if(E.cx > 0) {
+    editorRowDelChar(row, E.cx - 1);
+    E.cx--;
+  } else if(E.cy > 0) {
+    E.cx = E.row[E.cy - 1].size;
+    editorRowAppendString(&E.row[E.cy - 1], row->chars, row->size);
+    editorDelRow(E.cy);
+    E.cy--;
+  }
+}
+
+/** editor operations **/
+void editorInsertChar(int c) {
+  if(E.cy == E.numrows) {
+    editorInsertRow(E.numrows, "", 0);
+  }
+
+  editorRowInsertChar(&E.row[E.cy], E.cx, c);
+  E.cx++;
+}
+
+void editorInsertNewLine() {
+  if(E.cx == 0) {
+    editorInsertRow(E.cy, "", 0);
+  } else {
+    erow *row = &E.row[E.cy];
+    editorInsertRow(E.cy + 1, &row->chars[E.cx], row->size - E.cx);
+    row = &E.row[E.cy];
+    editorIndexRowResized(row, E.cx - row->size);
+    row->size = E.cx;
+    row->chars[row->size] = '\0';
+    editorUpdateRow(row);
+  }
+
+  E.cy++;
+  E.cx = 0;
+}
+
+/** file i/o **/
+
+char *editorRowsToString(int *buflen) {
+  editorIndexEnsure();
+  int totlen = lineIndexTotal(&E.lineidx);
+  int j;
+
+  *buflen = totlen;
+
+  char *buf = ALLOC_MALLOC(ALLOC_IO, totlen);
+  char *p = buf;
+
+  for(j = 0; j < E.numrows; j++) {
+    memcpy(p, E.row[j].chars, E.row[j].size);
+    p += E.row[j].size;
+    *p = '\n';
+    p++;
+  }
+
+  return buf;
+}
+
+// drop every row so another file can be opened in their place
+void editorCloseFile() {
+  int j;
+  for(j = 0; j < E.numrows; j++) {
+    editorFreeRow(&E.row[j]);
+  }
+  ALLOC_FREE(ALLOC_ROWS, E.row);
+  E.row = NULL;
+  E.numrows = 0;
+  E.rowcap = 0;
+
+  E.cx = 0;
+  E.cy = 0;
+  E.rx = 0;
+  E.rowoff = 0;
+  E.coloff = 0;
+  E.dirty = 0;
+  E.folds = 0;
+  E.hl_frontier = 0;
+
+  // indexes are sized to the file, so give their memory back too
+  lineIndexFree(&E.lineidx);
+  bracketIndexFree(&E.bracketidx);
+  lineIndexFree(&E.foldidx);
+  ALLOC_FREE(ALLOC_SYNTAX, E.outline.rows);
+  E.outline.rows = NULL;
+  E.outline.count = 0;
+  E.outline.cap = 0;
+  ALLOC_FREE(ALLOC_INDEX, E.timeidx.times);
+  ALLOC_FREE(ALLOC_INDEX, E.timeidx.rows);
+  E.timeidx.times = NULL;
+  E.timeidx.rows = NULL;
+  E.timeidx.cap = 0;
+  editorTimeIndexReset();
+}
+
+// modification time of a file in nanoseconds, for noticing changes on disk
+long long editorStatTime(const struct stat *st) {
+  return st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+// read filename into the buffer. Returns -1 with errno set when the file
+// can't be opened, leaving the buffer as it was
+int editorLoad(const char *filename) {
+  FILE *fp = fopen(filename, "r");
+  if(!fp) {
+    return -1;
+  }
+
+  int phase = profileSetPhase(PROFILE_LOAD);
+  TRACE_BEGIN("load");
+  struct stat st;
+  E.mtime = 0;
+  E.dev = 0;
+  E.ino = 0;
+  if(fstat(fileno(fp), &st) == 0) {
+    E.mtime = editorStatTime(&st);
+    E.dev = st.st_dev;
+    E.ino = st.st_ino;
+  }
+  ALLOC_FREE(ALLOC_IO, E.filename);
+  E.filename = ALLOC_STRDUP(ALLOC_IO, filename);
+
+  editorSelectSyntaxHighlight();
+
+  char *line = NULL;
+  size_t linecap = 0;
+  ssize_t linelen;
+
+  while((linelen = getline(&line, &linecap, fp)) != -1){
+    while(linelen > 0 && (line[linelen-1] == '\n' || line[linelen-1] == '\r')) {
+      linelen--;
+    }
+    editorInsertRow(E.numrows, line, linelen);
+  }
+
+  free(line);
+  fclose(fp);
+  editorTimeIndexReset();
+  E.dirty = 0;
+  TRACE_END("load");
+  profileSetPhase(phase);
+  return 0;
+}
+
+void editorOpen(char *filename) {
+  if(editorLoad(filename) == -1) {
+    die("fopen");
+  }
+}
+
+// write every row out to E.filename. Returns the bytes written, or -1
+// with errno set
+int editorSaveFile() {
+  int phase = profileSetPhase(PROFILE_SAVE);
+  TRACE_BEGIN("save");
+  PROBE1(save_start, E.filename);
+  int len;
+  char *buf = editorRowsToString(&len);
+  int err = 0;
+
+  errno = 0;
+  int fd = open(E.filename, O_RDWR | O_CREAT, 0644);
+  if(fd == -1 || ftruncate(fd, len) == -1 || write(fd, buf, len) != len) {
+    err = errno ? errno : EIO;
+  }
+  struct stat st;
+  if(err == 0 && fstat(fd, &st) == 0) {
+    E.mtime = editorStatTime(&st);
+    E.dev = st.st_dev;
+    E.ino = st.st_ino;
+  }
+  if(fd != -1) {
+    close(fd);
+  }
+  ALLOC_FREE(ALLOC_IO, buf);
+
+  if(err == 0) {
+    E.dirty = 0;
+  }
+  TRACE_END("save");
+  PROBE2(save_end, len, err);
+  profileSetPhase(phase);
+
+  errno = err;
+  return err ? -1 : len;
+}
+
+void editorSave() {
+  if(E.filename == NULL) {
+    char *filename = editorPrompt("save as: %s (esc to cancel)", NULL, NULL);
+    if(filename == NULL) {
+      editorSetStatusMessage("Save aborted");
+      return;
+    }
+    E.filename = ALLOC_STRDUP(ALLOC_IO, filename); // owned by the file like editorLoad's copy
+    ALLOC_FREE(ALLOC_UI, filename);
+    if(E.filename == NULL) {
+      editorSetStatusMessage("Can't save! %s", strerror(errno));
+      return;
+    }
+    editorSelectSyntaxHighlight();
+  }
+
+  int len = editorSaveFile();
+  if(len == -1) {
+    editorSetStatusMessage("Can't save! I/O Error: %s", strerror(errno));
+    return;
+  }
+  editorSetStatusMessage("%d bytes written to disk", len);
+}
+
+/** buffers **/
+
+// every open file has an editorConfig of its own and E points at the one
+// on screen. Switching only moves the terminal side (screen size,
+// headless run, latency, termios) over to the new buffer and repaints.
+// All buffers share one memory budget: when they go over it, the render
+// and highlight caches and indexes of the least recently shown buffers
+// are dropped, to be rebuilt when they are shown again
+static struct {
+  struct editorConfig **list;
+  int count;
+  int cap;
+  unsigned long long clock; // bumped on every switch, for LRU order
+  long long budget; // bytes all buffers may use before caches are evicted
+} editorBuffers = {NULL, 0, 0, 0, ConchPad_MEMORY_BUDGET};
+
+// make the terminal editor's own state the first buffer
+void editorBufferRegister() {
+  editorBuffers.list = ALLOC_MALLOC(ALLOC_UI, sizeof(*editorBuffers.list) * 8);
+  if(editorBuffers.list == NULL) {
+    die("malloc");
+  }
+  editorBuffers.cap = 8;
+  editorBuffers.list[0] = editorState;
+  editorBuffers.count = 1;
+  E.shown = ++editorBuffers.clock;
+}
+
+// the buffer shown most recently
+int editorBufferRecent() {
+  int best = 0;
+  int j;
+  for(j = 1; j < editorBuffers.count; j++) {
+    if(editorBuffers.list[j]->shown > editorBuffers.list[best]->shown) {
+      best = j;
+    }
+  }
+  return best;
+}
+
+int editorBufferCount() {
+  return editorBuffers.count;
+}
+
+int editorBufferCurrent() {
+  int j;
+  for(j = 0; j < editorBuffers.count; j++) {
+    if(editorBuffers.list[j] == editorState) {
+      return j;
+    }
+  }
+  return -1;
+}
+
+void editorBufferSetBudget(long long bytes) {
+  editorBuffers.budget = bytes;
+}
+
+// text plus caches held by buffer b. The row totals are kept as rows
+// grow and shrink, so this doesn't depend on the buffer's size
+long long editorBufferBytes(struct editorConfig *b, long long *caches) {
+  long long text = (long long) b->rowcap * sizeof(erow) + b->textbytes;
+  long long cached = __atomic_load_n(&b->cachebytes, __ATOMIC_RELAXED) +
+    (long long) (b->lineidx.cap + b->foldidx.cap) * sizeof(long long) +
+    (long long) b->bracketidx.size * 2 * BRACKET_KINDS * sizeof(struct bracketSummary);
+  if(caches) {
+    *caches = cached;
+  }
+  return text + cached;
+}
+
+// drop everything of b that can be rebuilt from its text
+void editorBufferEvict(struct editorConfig *b) {
+  int j;
+  for(j = 0; j < b->numrows; j++) {
+    erow *row = &b->row[j];
+    ALLOC_FREE(ALLOC_RENDER, row->render);
+    ALLOC_FREE(ALLOC_SYNTAX, row->hl);
+    row->render = NULL;
+    row->hl = NULL;
+    row->rsize = 0;
+    row->rcap = 0;
+    row->hlcap = 0;
+    row->hl_instate = -1;
+  }
+  lineIndexFree(&b->lineidx);
+  bracketIndexFree(&b->bracketidx);
+  lineIndexFree(&b->foldidx);
+  b->cachebytes = 0;
+  b->hl_frontier = 0;
+  b->evicted = 1;
+}
+
+// evict the least recently shown buffers until everything fits the budget
+void editorBufferBudget() {
+  if(editorBuffers.budget <= 0) {
+    return;
+  }
+
+  long long total = 0;
+  int j;
+  for(j = 0; j < editorBuffers.count; j++) {
+    total += editorBufferBytes(editorBuffers.list[j], NULL);
+  }
+
+  while(total > editorBuffers.budget) {
+    struct editorConfig *lru = NULL;
+    for(j = 0; j < editorBuffers.count; j++) {
+      struct editorConfig *b = editorBuffers.list[j];
+      if(b != editorState && b->viewers == 0 && !b->evicted && (lru == NULL || b->shown < lru->shown)) {
+        lru = b;
+      }
+    }
+    if(lru == NULL) {
+      break;
+    }
+
+    long long caches;
+    editorBufferBytes(lru, &caches);
+    editorBufferEvict(lru);
+    total -= caches;
+  }
+}
+
+// carry the terminal side of the editor over from one buffer to another
+void editorBufferCarry(struct editorConfig *to, struct editorConfig *from) {
+  to->screenrows = from->screenrows;
+  to->screencols = from->screencols;
+  to->headless = from->headless;
+  to->latency = from->latency;
+  to->orig_termios = from->orig_termios;
+  to->ttyin = from->ttyin;
+  to->ttyout = from->ttyout;
+  to->session = from->session;
+}
+
+void editorBufferSwitch(int at) {
+  if(at < 0 || at >= editorBuffers.count || editorBuffers.list[at] == editorState) {
+    return;
+  }
+
+  struct editorConfig *to = editorBuffers.list[at];
+  editorBufferCarry(to, editorState);
+  editorState = to;
+  E.shown = ++editorBuffers.clock;
+  editorBufferRestore();
+  editorBufferBudget();
+}
+
+// an evicted buffer gets its render text back when shown again;
+// highlighting catches up from the viewport like after a fresh open
+void editorBufferRestore() {
+  if(E.evicted) {
+    int j;
+    for(j = 0; j < E.numrows; j++) {
+      editorRowRender(&E.row[j]);
+    }
+    E.evicted = 0;
+  }
+}
+
+// load filename into a new buffer without showing it. Returns its index,
+// or -1 with errno set
+int editorBufferAdd(const char *filename) {
+  if(editorBuffers.count == editorBuffers.cap) {
+    int cap = editorBuffers.cap ? editorBuffers.cap * 2 : 8;
+    struct editorConfig **list = ALLOC_REALLOC(ALLOC_UI, editorBuffers.list, sizeof(*list) * cap);
+    if(list == NULL) {
+      return -1;
+    }
+    editorBuffers.list = list;
+    editorBuffers.cap = cap;
+  }
+
+  struct editorConfig *b = ALLOC_CALLOC(ALLOC_UI, 1, sizeof(struct editorConfig));
+  if(b == NULL) {
+    return -1;
+  }
+
+  struct editorConfig *prev = editorState;
+  editorState = b;
+  editorInitState();
+  int loaded = editorLoad(filename);
+  if(loaded == -1) {
+    int err = errno;
+    editorFreeState();
+    editorState = prev;
+    ALLOC_FREE(ALLOC_UI, b);
+    errno = err;
+    return -1;
+  }
+  editorState = prev;
+  editorBufferCarry(b, prev);
+
+  editorBuffers.list[editorBuffers.count] = b;
+  return editorBuffers.count++;
+}
+
+// the buffer holding filename, by name or as the same file opened under
+// another name (foo.c, ./foo.c, /abs/foo.c); -1 if it isn't open
+int editorBufferFind(const char *filename) {
+  struct stat st;
+  int exists = stat(filename, &st) == 0;
+  int j;
+  for(j = 0; j < editorBuffers.count; j++) {
+    struct editorConfig *b = editorBuffers.list[j];
+    if(b->filename && ((exists && b->ino && b->ino == st.st_ino && b->dev == st.st_dev) ||
+        !strcmp(b->filename, filename))) {
+      return j;
+    }
+  }
+  return -1;
+}
+
+// show filename, switching to it if it is already open. An untouched
+// empty buffer is reused instead of left behind
+int editorBufferOpen(const char *filename) {
+  int open = editorBufferFind(filename);
+  if(open != -1) {
+    editorBufferSwitch(open);
+    return 0;
+  }
+
+  if(E.filename == NULL && E.numrows == 0 && !E.dirty) {
+    if(editorLoad(filename) == -1) {
+      return -1;
+    }
+    editorBufferBudget();
+    return 0;
+  }
+
+  int at = editorBufferAdd(filename);
+  if(at == -1) {
+    return -1;
+  }
+  editorBufferSwitch(at);
+  return 0;
+}
+
+// Ctrl-E
+void editorBufferOpenPrompt() {
+  char *filename = editorPrompt("Open: %s (esc to cancel)", NULL, NULL);
+  if(filename == NULL) {
+    return;
+  }
+
+  if(editorBufferOpen(filename) == -1) {
+    editorSetStatusMessage("Can't open %s: %s", filename, strerror(errno));
+  }
+  ALLOC_FREE(ALLOC_UI, filename);
+}
+
+// Ctrl-W: pick a buffer by number or by part of its name
+void editorBufferPrompt() {
+  char list[80];
+  int len = 0;
+  int cur = editorBufferCurrent();
+  int j;
+  for(j = 0; j < editorBuffers.count && len < (int) sizeof(list) - 1; j++) {
+    const char *name = editorBuffers.list[j]->filename;
+    const char *slash = name ? strrchr(name, '/') : NULL;
+    len += snprintf(&list[len], sizeof(list) - len, "%s%d%s:%s", j ? " " : "", j + 1,
+      j == cur ? "*" : editorBuffers.list[j]->dirty ? "+" : "",
+      slash ? slash + 1 : name ? name : "[No Name]");
+  }
+
+  // the list becomes part of the prompt's format
+  char *pct;
+  while((pct = strchr(list, '%')) != NULL) {
+    *pct = '?';
+  }
+  char prompt[128];
+  snprintf(prompt, sizeof(prompt), "%.70s > %%s", list);
+  char *query = editorPrompt(prompt, NULL, NULL);
+  if(query == NULL) {
+    return;
+  }
+
+  char *end;
+  long n = strtol(query, &end, 10);
+  int at = -1;
+  if(end != query && *end == '\0') {
+    at = n - 1;
+  } else {
+    for(j = 0; j < editorBuffers.count && at == -1; j++) {
+      const char *name = editorBuffers.list[j]->filename;
+      if(name && strstr(name, query)) {
+        at = j;
+      }
+    }
+  }
+
+  if(at < 0 || at >= editorBuffers.count) {
+    editorSetStatusMessage("No buffer %s", query);
+  } else {
+    editorBufferSwitch(at);
+  }
+  ALLOC_FREE(ALLOC_UI, query);
+}
+
+// unsaved changes in any buffer
+int editorBuffersDirty() {
+  int j;
+  for(j = 0; j < editorBuffers.count; j++) {
+    if(editorBuffers.list[j]->dirty) {
+      return 1;
+    }
+  }
+  return E.dirty;
+}
+
+/** append buffer **/
+
+// create an append buffer struct to replace direct STDOUT writes
+struct abuf {
+  char *b;
+  int len;
+  int cap;
+};
+
+#define ABUF_INIT {NULL, 0, 0}
+
+// Append to the buffer via memcpy to chunk our write calls, doubling the
+// allocation whenever it runs out
+void abAppend(struct abuf *ab, const char *s, int len) {
+  if(ab->len + len > ab->cap) {
+    int cap = ab->cap ? ab->cap * 2 : 4096;
+    while(cap < ab->len + len) {
+      cap *= 2;
+    }
+    char *new = ALLOC_REALLOC(ALLOC_RENDER, ab->b, cap);
+    if(new == NULL) {
+      return;
+    }
+    ab->b = new;
+    ab->cap = cap;
+  }
+
+  memcpy(&ab->b[ab->len], s, len);
+  ab->len += len;
+}
+
+/** draw target **/
+
+// frames are drawn through a target: VT escapes into the frame buffer for
+// a terminal, or straight into a cell grid for an embedding host
+struct drawTarget {
+  struct abuf *ab; // escape sequences, when drawing for a terminal
+  cellGrid *grid; // cells, when drawing for a host
+  int y; // screen row being drawn
+  int last; // last screen row, which isn't followed by a line break
+  int style; // color | CELL_* flags in effect
+};
+
+// switch to style, emitting only the attributes that changed. Flags are
+// turned off before the color changes and on after it
+void editorDrawStyle(struct drawTarget *dt, int style) {
+  if(style == dt->style) {
+    return;
+  }
+
+  if(dt->ab) {
+    int off = dt->style & ~style;
+    int on = style & ~dt->style;
+    if(off & CELL_REVERSE) {
+      abAppend(dt->ab, "\x1b[27m", 5);
+    }
+    if(off & CELL_DIM) {
+      abAppend(dt->ab, "\x1b[22m", 5);
+    }
+    if((style & CELL_COLOR) != (dt->style & CELL_COLOR)) {
+      char buf[16];
+      int clen = snprintf(buf, sizeof(buf), "\x1b[%dm", style & CELL_COLOR ? style & CELL_COLOR : 39);
+      abAppend(dt->ab, buf, clen);
+    }
+    if(on & CELL_REVERSE) {
+      abAppend(dt->ab, "\x1b[7m", 4);
+    }
+    if(on & CELL_DIM) {
+      abAppend(dt->ab, "\x1b[2m", 4);
+    }
+  }
+  dt->style = style;
+}
+
+void editorDrawText(struct drawTarget *dt, const char *s, int len) {
+  if(dt->ab) {
+    abAppend(dt->ab, s, len);
+  } else {
+    cellGridText(dt->grid, s, len, dt->style);
+  }
+}
+
+// blank the rest of the row in the default style and move to the next one
+void editorDrawEndLine(struct drawTarget *dt) {
+  editorDrawStyle(dt, 0);
+  if(dt->ab) {
+    abAppend(dt->ab, "\x1b[K", 3); // source: http://vt100.net/docs/vt100-ug/chapter3.html#EL
+    if(dt->y < dt->last) {
+      abAppend(dt->ab, "\r\n", 2);
+    }
+  } else {
+    cellGridEndRow(dt->grid, dt->y);
+  }
+  dt->y++;
+}
+
+
+/** output **/
+
+void editorScroll() {
+  TRACE_BEGIN("scroll");
+  E.rx = E.cx;
+
+  if(E.cy < E.numrows) {
+    E.rx = editorRowCxToRx(&E.row[E.cy], E.cx);
+  }
+
+  // anything that moves the cursor into a fold opens it
+  if(E.cy < E.numrows && E.row[E.cy].hidden) {
+    editorUnfoldAround(E.cy, 0);
+  }
+  if(E.rowoff < E.numrows && E.row[E.rowoff].hidden) {
+    E.rowoff = editorVisibleRow(editorVisibleIndex(E.rowoff) - 1);
+  }
+
+  if(E.cy < E.rowoff) {
+    E.rowoff = E.cy;
+  }
+
+  int line = editorVisibleIndex(E.cy);
+  if(line >= editorVisibleIndex(E.rowoff) + E.screenrows) {
+    E.rowoff = editorVisibleRow(line - E.screenrows + 1);
+  }
+  if(E.rx < E.coloff) {
+    E.coloff = E.rx;
+  }
+  if (E.rx >= E.coloff + E.screencols) {
+    E.coloff = E.rx - E.screencols + 1;
+  }
+  TRACE_END("scroll");
+}
+
+// draw each row of the buffer text being edited
+// for now draws a tilde in each row meaning the row is not part of the file
+// and cannot contain any text
+// we don't know the terminal size yet, so default to 24 rows
+void editorDrawRows(struct drawTarget *dt) {
+  int y;
+  int filerow = E.rowoff;
+  for (y = 0; y < E.screenrows; y++, filerow = editorNextRow(filerow)) {
+    if(filerow >= E.numrows) {
+      // Add in a welcome message to the top of the screen
+      if (E.numrows == 0 && y == E.screenrows / 3) {
+        char welcome[80];
+        int welcomelen = snprintf(welcome, sizeof(welcome),
+          "ConchPad editor -- version %s", ConchPad_VERSION);
+        if(welcomelen > E.screencols) {
+          welcomelen = E.screencols;
+        }
+
+        int padding = (E.screencols - welcomelen) / 2;
+        if(padding) {
+          editorDrawText(dt, "~", 1);
+          padding--;
+        }
+        while(padding--) {
+          editorDrawText(dt, " ", 1);
+        }
+
+        editorDrawText(dt, welcome, welcomelen);
+      } else {
+        editorDrawText(dt, "~", 1);
+      }
+    } else {
+      int len = E.row[filerow].rsize - E.coloff;
+      
+      if(len < 0) {
+        len = 0;
+      }
+
+      if(len > E.screencols) {
+        len = E.screencols;
+      }
+
+      char *c = &E.row[filerow].render[E.coloff];
+      // rows the highlighter hasn't reached yet draw plain
+      unsigned char *hl = E.row[filerow].hl_instate >= 0 ? &E.row[filerow].hl[E.coloff] : NULL;
+      int match = filerow == E.match_row ? E.match_rx - E.coloff : -1;
+      int j = 0;
+      while(j < len) {
+        // draw runs of one style at a time
+        int style = hl == NULL || hl[j] == HL_NORMAL ? 0 : syntaxToColor(hl[j]);
+        int run = 1;
+        if(j == match) {
+          style |= CELL_REVERSE;
+        } else {
+          while(j + run < len && j + run != match &&
+              (hl == NULL ? 0 : hl[j + run]) == (hl == NULL ? 0 : hl[j])) {
+            run++;
+          }
+        }
+        editorDrawStyle(dt, style);
+        editorDrawText(dt, &c[j], run);
+        j += run;
+      }
+
+      if(E.row[filerow].fold) {
+        char marker[32];
+        int mlen = snprintf(marker, sizeof(marker), " [+%d]", E.row[filerow].fold);
+        if(len + mlen <= E.screencols) {
+          editorDrawStyle(dt, CELL_DIM);
+          editorDrawText(dt, marker, mlen);
+        }
+      }
+    }
+
+    // redraw each line as it is edited (replace previous whole screen refresh)
+    editorDrawEndLine(dt);
+  }
+}
+
+void editorDrawStatusBar(struct drawTarget *dt) {
+  editorDrawStyle(dt, CELL_REVERSE);
+  
+  char status[80];
+  char rstatus[80];
+
+  int len = snprintf(status, sizeof(status), "%.20s - %d lines %s %s",
+    E.filename ? E.filename : "[No Name]", E.numrows,
+    E.syntax ? E.syntax->filetype : "no ft",
+    E.dirty ? "(modified)" : "");
+
+  char when[32] = "";
+  long long t;
+  if(editorCursorTime(&t) == 0) {
+    int wlen = tsFormatTime(E.timeidx.fmt, t, when, sizeof(when) - 3);
+    memcpy(&when[wlen], " | ", 4);
+  }
+
+  char which[24] = "";
+  if(editorBufferCount() > 1) {
+    snprintf(which, sizeof(which), "buf %d/%d | ", editorBufferCurrent() + 1, editorBufferCount());
+  }
+
+  int rlen = snprintf(rstatus, sizeof(rstatus), "%s%sbyte %lld | %d/%d",
+    which, when, editorCursorOffset(), E.cy + 1, E.numrows);
+
+  if(len > E.screencols) {
+    len = E.screencols;
+  }
+
+  editorDrawText(dt, status, len);
+
+  while(len < E.screencols) {
+    if(E.screencols - len == rlen) {
+      editorDrawText(dt, rstatus, rlen);
+      break;
+    } else {
+      editorDrawText(dt, " ", 1);
+      len++;
+    }
+  }
+
+  editorDrawEndLine(dt);
+}
+
+void editorDrawMessageBar(struct drawTarget *dt){ 
+  // the latency overlay takes the right end of the bar
+  char stats[96];
+  int statslen = 0;
+  if(E.latency.overlay) {
+    statslen = editorLatencySummary(stats, sizeof(stats));
+    if(statslen >= E.screencols) {
+      statslen = 0;
+    }
+  }
+
+  int msglen = strlen(E.statusmsg);
+  if(msglen > E.screencols - statslen) {
+    msglen = E.screencols - statslen;
+  }
+  if(msglen && time(NULL) - E.statusmsg_time < 5) {
+    editorDrawText(dt, E.statusmsg, msglen);
+  } else {
+    msglen = 0;
+  }
+
+  if(statslen) {
+    while(msglen++ < E.screencols - statslen) {
+      editorDrawText(dt, " ", 1);
+    }
+    editorDrawStyle(dt, CELL_DIM);
+    editorDrawText(dt, stats, statslen);
+  }
+
+  editorDrawEndLine(dt);
+}
+
+// scroll, bring the visible rows' highlighting up to date and find the
+// bracket partner, ready for drawing
+void editorFramePrepare() {
+  editorScroll();
+  TRACE_BEGIN("highlight viewport");
+  editorHighlightViewport();
+  TRACE_END("highlight viewport");
+
+  if(editorBracketMatch(E.cy, E.rx, &E.match_row, &E.match_rx) != 0) {
+    E.match_row = -1;
+  }
+}
+
+// write 4 bytes to the terminal
+// \x1b is the escape character
+// escape char is always followed by '['
+// J is the erase in display command
+// escape sequence commands take args that come before.
+// 1 would clear screen up to cursor; 2 clears entire display
+// Source for cursor commands: https://vt100.net/docs/vt100-ug/chapter3.html#S3.3.4
+void editorScreenRefresh() {
+  long long start = editorNow();
+  int phase = profileSetPhase(PROFILE_RENDER);
+  PROBE(frame_start);
+  TRACE_BEGIN("frame");
+  editorFramePrepare();
+
+  // the frame buffer is kept between frames, so once it has grown to a
+  // full screen drawing doesn't allocate
+  static struct abuf ab = ABUF_INIT;
+  ab.len = 0;
+  struct drawTarget dt = {&ab, NULL, 0, E.screenrows + 1, 0};
+
+  TRACE_BEGIN("draw");
+  abAppend(&ab, "\x1b[?25l", 6); // hide the cursor from view (stops flickering)
+  // abAppend(&ab, "\x1b[2J", 4); // reset entire screen
+  abAppend(&ab, "\x1b[H", 3); // reposition the cursor to top left
+
+  editorDrawRows(&dt);
+  editorDrawStatusBar(&dt);
+  editorDrawMessageBar(&dt);
+
+  char buf[32];
+  // set cursor argument [H] the the x, y coordinates
+  // then write to the buffer
+  snprintf(buf, sizeof(buf), "\x1b[%d;%dH", editorVisibleIndex(E.cy) - editorVisibleIndex(E.rowoff) + 1,
+    (E.rx - E.coloff) + 1);
+  abAppend(&ab, buf, strlen(buf));
+
+  abAppend(&ab, "\x1b[?25h", 6); // set the cursor to be visible again
+  TRACE_END("draw");
+
+  TRACE_BEGIN("write");
+  editorWrite(ab.b, ab.len);
+  TRACE_END("write");
+  editorLatencyFrame(start, ab.len);
+  E.headless.frames++;
+  TRACE_END("frame");
+  PROBE2(frame_end, ab.len, editorNow() - start);
+  profileSetPhase(phase);
+}
+
+// draw the frame into grid instead of the terminal, sizing the view to
+// it. grid->damage says which cells changed since the last frame
+int editorRenderCells(cellGrid *grid) {
+  if(grid->rows < 3) {
+    return -1;
+  }
+
+  int phase = profileSetPhase(PROFILE_RENDER);
+  TRACE_BEGIN("frame cells");
+  E.screenrows = grid->rows - 2;
+  E.screencols = grid->cols;
+  editorFramePrepare();
+
+  struct drawTarget dt = {NULL, grid, 0, grid->rows - 1, 0};
+  cellGridBegin(grid);
+  editorDrawRows(&dt);
+  editorDrawStatusBar(&dt);
+  editorDrawMessageBar(&dt);
+  grid->cursor_y = editorVisibleIndex(E.cy) - editorVisibleIndex(E.rowoff);
+  grid->cursor_x = E.rx - E.coloff;
+
+  TRACE_END("frame cells");
+  profileSetPhase(phase);
+  return 0;
+}
+
+void editorSetStatusMessage(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+
+  vsnprintf(E.statusmsg, sizeof(E.statusmsg), fmt, ap);
+  va_end(ap);
+  E.statusmsg_time = time(NULL);
+}
+
+/** input **/
+
+// read a line on the message bar. callback (if set) sees the buffer after
+// every key, including the final enter / escape, along with arg. Prompt
+// state lives in arg rather than in statics, since daemon terminals can
+// have prompts open at the same time
+char *editorPrompt(char *prompt, void (*callback)(char *, int, void *), void *arg) {
+  size_t bufsize = 128;
+  char *buf = ALLOC_MALLOC(ALLOC_UI, bufsize);
+
+  size_t buflen = 0;
+  buf[0] = '\0';
+
+  while(1) {
+    editorSetStatusMessage(prompt, buf);
+    editorScreenRefresh();
+
+    int c = editorReadKey();
+    if(c == DEL_KEY || c == CTRL_KEY('h') || c == BACKSPACE) {
+      if(buflen != 0) {
+        buf[--buflen] = '\0';
+      }
+    } else if(c == '\x1b') {
+      editorSetStatusMessage("");
+      if(callback) {
+        callback(buf, c, arg);
+      }
+      ALLOC_FREE(ALLOC_UI, buf);
+      return NULL;
+    } else if(c == '\r') {
+      if(buflen != 0) {
+        editorSetStatusMessage("");
+        if(callback) {
+          callback(buf, c, arg);
+        }
+        return buf;
+      }
+    } else if(!iscntrl(c) && c < 128) {
+      if(buflen == bufsize - 1) {
+        bufsize *= 2;
+        buf = ALLOC_REALLOC(ALLOC_UI, buf, bufsize);
+      }
+      buf[buflen++] = c;
+      buf[buflen] = '\0';
+    }
+
+    if(callback && c != '\r') {
+      callback(buf, c, arg);
+    }
+  }
+}
+
+// jump to a line number, a byte offset (@1234) or a percentage of the
+// file's bytes (50%). All three are answered by the line index in O(log n)
+void editorGoto() {
+  char *query = editorPrompt("Goto line, @byte or N%%: %s (esc to cancel)", NULL, NULL);
+  if(query == NULL) {
+    return;
+  }
+
+  char *end;
+  if(query[0] == '@') {
+    long long offset = strtoll(&query[1], &end, 10);
+    if(end != &query[1] && *end == '\0' && offset >= 0) {
+      editorGotoOffset(offset);
+    } else {
+      editorSetStatusMessage("Invalid byte offset: %s", query);
+    }
+  } else {
+    long long n = strtoll(query, &end, 10);
+    if(end == query || (*end != '\0' && strcmp(end, "%") != 0)) {
+      editorSetStatusMessage("Invalid goto: %s", query);
+    } else if(*end == '%') {
+      if(n < 0) n = 0;
+      if(n > 100) n = 100;
+      editorIndexEnsure();
+      editorGotoOffset(lineIndexTotal(&E.lineidx) * n / 100);
+    } else {
+      if(n < 1) n = 1;
+      if(n > E.numrows) n = E.numrows;
+      E.cy = n > 0 ? n - 1 : 0;
+      E.cx = 0;
+    }
+  }
+
+  ALLOC_FREE(ALLOC_UI, query);
+}
+
+// lower bound over the in-memory rows, used when the buffer no longer
+// matches what is on disk
+int editorSeekRows(const char *key, size_t keylen) {
+  int lo = 0;
+  int hi = E.numrows;
+
+  while(lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    erow *row = &E.row[mid];
+    size_t n = (size_t) row->size < keylen ? (size_t) row->size : keylen;
+    int cmp = memcmp(row->chars, key, n);
+    if(cmp == 0 && (size_t) row->size < keylen) {
+      cmp = -1;
+    }
+
+    if(cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+// jump to the first line >= key in a sorted file. When the buffer is clean
+// the file itself is binary searched through mmap and the resulting byte
+// offset is mapped back to a row with the line index
+void editorSeekKey() {
+  char *key = editorPrompt("Seek to key (sorted file): %s (esc to cancel)", NULL, NULL);
+  if(key == NULL) {
+    return;
+  }
+
+  size_t keylen = strlen(key);
+  int target = -1;
+
+  if(!E.dirty && E.filename) {
+    long long offset;
+    char line[64];
+    if(sortedSeekFile(E.filename, key, keylen, &offset, line, sizeof(line)) == 0) {
+      editorIndexEnsure();
+      if(offset >= lineIndexTotal(&E.lineidx)) {
+        target = E.numrows;
+      } else {
+        int at = lineIndexFind(&E.lineidx, offset);
+        // offsets only line up if the file round-trips exactly (no \r\n)
+        if(at >= 0 && lineIndexPrefix(&E.lineidx, at) == offset
+            && strncmp(E.row[at].chars, line, strlen(line)) == 0) {
+          target = at;
+        }
+      }
+    }
+  }
+
+  if(target == -1) {
+    target = editorSeekRows(key, keylen);
+  }
+
+  if(target >= E.numrows) {
+    editorSetStatusMessage("No line >= \"%s\"", key);
+  } else {
+    E.cy = target;
+    E.cx = 0;
+    if(strncmp(E.row[target].chars, key, keylen) != 0) {
+      editorSetStatusMessage("No exact match for \"%s\", stopped at next line", key);
+    }
+  }
+
+  ALLOC_FREE(ALLOC_UI, key);
+}
+
+// navigate a log by time: "14:32:05", "+5m", or "+" / "-" for the
+// next / previous minute
+void editorGotoTime() {
+  if(E.timeidx.fmt == TS_NONE) {
+    editorTimeIndexReset();
+    editorTimeIndexDetect();
+  }
+  if(E.timeidx.fmt == TS_NONE) {
+    editorSetStatusMessage("No timestamps detected in this file");
+    return;
+  }
+
+  char *query = editorPrompt("Goto time (HH:MM:SS, +5m, + / - minute): %s (esc to cancel)", NULL, NULL);
+  if(query == NULL) {
+    return;
+  }
+
+  long long ref = 0;
+  long long target;
+  editorCursorTime(&ref);
+
+  if(tsParseQuery(E.timeidx.fmt, query, ref, &target) != 0) {
+    editorSetStatusMessage("Invalid time: %s", query);
+  } else {
+    int at = editorTimeIndexFind(target);
+    if(at == -1) {
+      editorSetStatusMessage("No %s timestamp at or after %s",
+        tsFormatName(E.timeidx.fmt), query);
+    } else {
+      E.cy = at;
+      E.cx = 0;
+    }
+  }
+
+  ALLOC_FREE(ALLOC_UI, query);
+}
+
+// move the cursor to the partner of the bracket under it
+void editorJumpBracket() {
+  if(E.cy >= E.numrows) {
+    return;
+  }
+
+  int rx = editorRowCxToRx(&E.row[E.cy], E.cx);
+  int row, mrx;
+  if(editorBracketMatch(E.cy, rx, &row, &mrx) != 0) {
+    editorSetStatusMessage("No matching bracket");
+    return;
+  }
+
+  E.cy = row;
+  E.cx = editorRowRxToCx(&E.row[row], mrx);
+}
+
+// next row (wrapping, starting after row from in direction dir) that
+// contains query. Returns the row and stores the byte offset of the match
+// in *col, or -1
+int editorFindRow(const char *query, int from, int dir, int *col) {
+  int j;
+  int at = from;
+  int phase = profileSetPhase(PROFILE_SEARCH);
+  PROBE2(search_start, query, from);
+  for(j = 0; j < E.numrows; j++) {
+    at += dir;
+    if(at < 0) {
+      at = E.numrows - 1;
+    } else if(at >= E.numrows) {
+      at = 0;
+    }
+
+    char *match = strstr(E.row[at].chars, query);
+    if(match) {
+      *col = match - E.row[at].chars;
+      PROBE2(search_end, at, j + 1);
+      profileSetPhase(phase);
+      return at;
+    }
+  }
+  PROBE2(search_end, -1, E.numrows);
+  profileSetPhase(phase);
+  return -1;
+}
+
+// an incremental search in progress
+struct findState {
+  int last; // row of the last match, -1 to search from the cursor
+  int dir;
+};
+
+void editorFindCallback(char *query, int key, void *arg) {
+  struct findState *find = arg;
+
+  if(key == '\r' || key == '\x1b') {
+    return;
+  } else if(key == ARROW_RIGHT || key == ARROW_DOWN) {
+    find->dir = 1;
+  } else if(key == ARROW_LEFT || key == ARROW_UP) {
+    find->dir = -1;
+  } else {
+    find->last = -1;
+    find->dir = 1;
+  }
+
+  if(query[0] == '\0') {
+    return;
+  }
+
+  int col;
+  int at = editorFindRow(query, find->last == -1 || find->last >= E.numrows ? E.cy - 1 : find->last,
+    find->dir, &col);
+  if(at >= 0) {
+    find->last = at;
+    E.cy = at;
+    E.cx = col;
+    E.rowoff = E.numrows; // bring the match to the top of the screen
+  }
+}
+
+// incremental search, escape goes back to where it started
+void editorFind() {
+  int saved_cx = E.cx;
+  int saved_cy = E.cy;
+  int saved_rowoff = E.rowoff;
+  int saved_coloff = E.coloff;
+
+  struct findState find = {-1, 1};
+  char *query = editorPrompt("Search: %s (arrows for next / prev, esc to cancel)",
+    editorFindCallback, &find);
+  if(query) {
+    ALLOC_FREE(ALLOC_UI, query);
+  } else {
+    E.cx = saved_cx;
+    E.cy = saved_cy;
+    E.rowoff = saved_rowoff;
+    E.coloff = saved_coloff;
+  }
+}
+
+// fuzzy match score of query against a symbol name, -1 if query isn't a
+// (case insensitive) subsequence of it. Matches at the start of the name or
+// of a word inside it, and runs of consecutive matches, score higher
+int editorFuzzyScore(const char *name, int len, const char *query) {
+  int score = 0;
+  int run = 0;
+  int i = 0;
+  const char *q;
+  for(q = query; *q; q++) {
+    while(i < len && tolower((unsigned char) name[i]) != tolower((unsigned char) *q)) {
+      i++;
+      run = 0;
+    }
+    if(i == len) {
+      return -1;
+    }
+
+    score += 10 + run * 5;
+    if(i == 0 || name[i - 1] == '_' || (islower((unsigned char) name[i - 1]) &&
+        isupper((unsigned char) name[i]))) {
+      score += 15;
+    }
+    run++;
+    i++;
+  }
+  return score * 64 - len; // shorter names win ties
+}
+
+int editorOutlineCompare(const void *a, const void *b, void *scores) {
+  int sa = ((int *) scores)[*(const int *) a];
+  int sb = ((int *) scores)[*(const int *) b];
+  if(sa != sb) {
+    return sb > sa ? 1 : -1;
+  }
+  return *(const int *) a - *(const int *) b;
+}
+
+void editorOutlineShow(int entry) {
+  // another terminal may have edited the buffer since the matches were
+  // scored
+  if(entry >= E.outline.count || E.outline.rows[entry] >= E.numrows) {
+    return;
+  }
+  int at = E.outline.rows[entry];
+  erow *row = &E.row[at];
+  E.cy = at;
+  E.cx = editorRowRxToCx(row, row->sym);
+  E.rowoff = E.numrows; // scroll the symbol to the top of the screen
+}
+
+// an outline prompt in progress
+struct outlineState {
+  int saved_cx;
+  int saved_cy;
+  int saved_rowoff;
+  int saved_coloff;
+  int *scores; // per outline entry, -1 where the query doesn't match
+  int *entries; // matching outline entries in score order
+  int count;
+  int current;
+};
+
+static void editorOutlineRestore(struct outlineState *o) {
+  E.cx = o->saved_cx;
+  E.cy = o->saved_cy;
+  E.rowoff = o->saved_rowoff;
+  E.coloff = o->saved_coloff;
+}
+
+void editorOutlineCallback(char *query, int key, void *arg) {
+  struct outlineState *o = arg;
+
+  if(key == '\r' || key == '\x1b') {
+    if(key == '\x1b' || o->count == 0) {
+      editorOutlineRestore(o);
+    }
+    return;
+  }
+
+  if(key == ARROW_DOWN || key == ARROW_RIGHT || key == ARROW_UP || key == ARROW_LEFT) {
+    if(o->count == 0) {
+      return;
+    }
+    int step = key == ARROW_DOWN || key == ARROW_RIGHT ? 1 : -1;
+    o->current = (o->current + step + o->count) % o->count;
+    editorOutlineShow(o->entries[o->current]);
+    return;
+  }
+
+  // rescore every symbol for the new query
+  ALLOC_FREE(ALLOC_UI, o->scores);
+  o->scores = ALLOC_MALLOC(ALLOC_UI, sizeof(int) * (E.outline.count ? E.outline.count : 1));
+  ALLOC_FREE(ALLOC_UI, o->entries);
+  o->entries = ALLOC_MALLOC(ALLOC_UI, sizeof(int) * (E.outline.count ? E.outline.count : 1));
+  o->count = 0;
+  o->current = 0;
+
+  int j;
+  for(j = 0; j < E.outline.count; j++) {
+    erow *row = &E.row[E.outline.rows[j]];
+    o->scores[j] = editorFuzzyScore(&row->render[row->sym], row->sym_len, query);
+    if(o->scores[j] >= 0) {
+      o->entries[o->count++] = j;
+    }
+  }
+  qsort_r(o->entries, o->count, sizeof(int), editorOutlineCompare, o->scores);
+
+  if(o->count > 0) {
+    editorOutlineShow(o->entries[0]);
+  } else {
+    editorOutlineRestore(o);
+  }
+}
+
+// jump to a symbol from the outline, narrowing as you type
+void editorOutlineJump() {
+  if(E.syntax == NULL) {
+    editorSetStatusMessage("No outline: unknown file type");
+    return;
+  }
+
+  struct outlineState o = {E.cx, E.cy, E.rowoff, E.coloff, NULL, NULL, 0, 0};
+  char *query = editorPrompt("Symbol: %s (arrows cycle, esc to cancel)", editorOutlineCallback, &o);
+  ALLOC_FREE(ALLOC_UI, query);
+  ALLOC_FREE(ALLOC_UI, o.scores);
+  ALLOC_FREE(ALLOC_UI, o.entries);
+}
+
+// row matching a tag's search pattern (or line number), -1 if none
+int editorTagRow(struct ctagsEntry *entry) {
+  int hint = entry->line - 1;
+  size_t plen = strlen(entry->pattern);
+
+  if(plen == 0) {
+    return hint >= 0 && hint < E.numrows ? hint : -1;
+  }
+
+  // try the line hint first, then the whole file
+  int j;
+  for(j = -1; j < E.numrows; j++) {
+    int at = j < 0 ? hint : j;
+    if(at < 0 || at >= E.numrows) {
+      continue;
+    }
+
+    erow *row = &E.row[at];
+    if((size_t) row->size >= plen && memcmp(row->chars, entry->pattern, plen) == 0 &&
+        (!entry->anchored || (size_t) row->size == plen)) {
+      return at;
+    }
+  }
+  return -1;
+}
+
+// go to the definition of the identifier under the cursor through the
+// nearest tags file. Pressing it again on the same word visits the next
+// definition when there is more than one
+void editorGotoTag() {
+  static __thread char last[256]; // per daemon terminal
+  static __thread int nth = 0;
+
+  if(E.cy >= E.numrows) {
+    return;
+  }
+
+  erow *row = &E.row[E.cy];
+  int start = E.cx;
+  int end = E.cx;
+  while(start > 0 && (isalnum((unsigned char) row->chars[start - 1]) || row->chars[start - 1] == '_')) {
+    start--;
+  }
+  while(end < row->size && (isalnum((unsigned char) row->chars[end]) || row->chars[end] == '_')) {
+    end++;
+  }
+  if(start == end || end - start >= (int) sizeof(last)) {
+    editorSetStatusMessage("No identifier under the cursor");
+    return;
+  }
+
+  char name[256];
+  memcpy(name, &row->chars[start], end - start);
+  name[end - start] = '\0';
+  nth = strcmp(name, last) == 0 ? nth + 1 : 0;
+  memcpy(last, name, sizeof(last));
+
+  char tagspath[PATH_MAX];
+  if(ctagsFind(E.filename, tagspath, sizeof(tagspath)) != 0) {
+    editorSetStatusMessage("No tags file found");
+    return;
+  }
+
+  struct ctagsEntry entry;
+  if(ctagsLookup(tagspath, name, nth, &entry) != 0) {
+    nth = 0; // past the last definition, wrap around
+    if(ctagsLookup(tagspath, name, nth, &entry) != 0) {
+      editorSetStatusMessage("Tag not found: %s", name);
+      return;
+    }
+  }
+
+  // another file opens in a buffer of its own, so edits here stay put and
+  // a file that can't be read only costs a message
+  if(editorBufferOpen(entry.file) == -1) {
+    editorSetStatusMessage("Can't open %s: %s", entry.file, strerror(errno));
+    return;
+  }
+
+  int at = editorTagRow(&entry);
+  if(at < 0) {
+    editorSetStatusMessage("%s: pattern for %s not found", entry.file, name);
+    return;
+  }
+
+  E.cy = at;
+  E.cx = 0;
+  char *hit = strstr(E.row[at].chars, name);
+  if(hit) {
+    E.cx = hit - E.row[at].chars;
+  }
+  E.rowoff = E.numrows; // put the definition at the top of the screen
+
+  if(entry.matches > 1) {
+    editorSetStatusMessage("%s: definition %d of %d", name, nth + 1, entry.matches);
+  }
+}
+
+void editorCursorMove(int key) {
+  erow *row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
+
+  switch (key) {
+    case ARROW_LEFT:
+      if(E.cx != 0) {
+        E.cx--;
+      } else if (E.cy > 0) {
+        E.cy = editorVisibleRow(editorVisibleIndex(E.cy) - 1);
+        E.cx = E.row[E.cy].size;
+      }
+      break;
+    case ARROW_RIGHT:
+      if(row && E.cx < row->size) {
+        E.cx++;
+      } else if(row && E.cx == row->size) {
+        E.cy = editorNextRow(E.cy);
+        E.cx = 0;
+      }
+      break;
+    case ARROW_UP:
+      if(E.cy != 0) {
+        E.cy = editorVisibleRow(editorVisibleIndex(E.cy) - 1);
+      }
+      break;
+    case ARROW_DOWN:
+      if(E.cy != E.numrows) {
+        E.cy = editorNextRow(E.cy);
+      }
+      break;
+  }
+
+  row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
+  int rowlen = row ? row->size : 0;
+  if(E.cx > rowlen) {
+    E.cx = rowlen;
+  }
+}
+
+// define the controls for our editor
+void editorProcessKeypress() {
+  static __thread int quite_times = ConchPad_QUIT_TIMES; // per daemon terminal
+
+  int input = editorReadKey();
+  int phase = profileSetPhase(PROFILE_INPUT);
+  TRACE_BEGIN("dispatch");
+
+  switch(input) { 
+    case '\r':
+      editorInsertNewLine();
+      break;
+
+    case CTRL_KEY('q'):
+      // a daemon's terminal just detaches, its buffers stay open
+      if(E.session) {
+        daemonDetach(E.session);
+        break;
+      }
+      // the count only survives consecutive presses, any other key resets
+      // it below
+      if(editorBuffersDirty() && quite_times > 0) {
+        editorSetStatusMessage("Warning! File has unsaved changes. "
+          "Press Ctrl-Q %d more times to quit.", quite_times);
+        quite_times--;
+        TRACE_END("dispatch");
+        profileSetPhase(phase);
+        return;
+      }
+      if(E.headless.active) {
+        E.headless.quit = 1;
+        break;
+      }
+      editorWrite("\x1b[2J", 4);
+      editorWrite("\x1b[H", 3);
+      TRACE_END("dispatch");
+      exit(0);
+      break; 
+
+    case CTRL_KEY('s'):
+      editorSave();
+      break;
+
+    case CTRL_KEY('g'):
+      editorGoto();
+      break;
+
+    case CTRL_KEY('k'):
+      editorSeekKey();
+      break;
+
+    case CTRL_KEY('t'):
+      editorGotoTime();
+      break;
+
+    case CTRL_KEY('b'):
+      editorJumpBracket();
+      break;
+
+    case CTRL_KEY('o'):
+      editorToggleFold();
+      break;
+
+    case CTRL_KEY('p'):
+      editorOutlineJump();
+      break;
+
+    case CTRL_KEY(']'):
+      editorGotoTag();
+      break;
+
+    case CTRL_KEY('f'):
+      editorFind();
+      break;
+
+    case CTRL_KEY('y'):
+      E.latency.overlay = !E.latency.overlay;
+      break;
+
+    case CTRL_KEY('u'):
+      editorToggleFoldAll();
+      break;
+
+    case CTRL_KEY('e'):
+      editorBufferOpenPrompt();
+      break;
+
+    case CTRL_KEY('n'):
+      editorBufferSwitch((editorBufferCurrent() + 1) % editorBufferCount());
+      break;
+
+    case CTRL_KEY('w'):
+      editorBufferPrompt();
+      break;
+
+    case HOME_KEY:
+      E.cx = 0;
+      break;
+    case END_KEY:
+      if(E.cy < E.numrows) {
+        E.cx = E.row[E.cy].size;
+      }
+      break;
+
+    case BACKSPACE:
+    case CTRL_KEY('h'):
+    case DEL_KEY:
+      if (input == DEL_KEY) {
+        editorCursorMove(ARROW_RIGHT);
+      }
+      editorDelChar();
+      break;
+
+    case PAGE_UP:
+    case PAGE_DOWN:
+      {
+        if(input == PAGE_UP) {
+          E.cy = E.rowoff;
+        } else if(input == PAGE_DOWN) {
+          E.cy = editorVisibleRow(editorVisibleIndex(E.rowoff) + E.screenrows - 1);
+        }
+
+        int times = E.screenrows;
+        while (times --) {
+          editorCursorMove(input == PAGE_UP ? ARROW_UP: ARROW_DOWN);
+        }
+      }
+
+    case ARROW_UP:
+    case ARROW_DOWN:
+    case ARROW_RIGHT:
+    case ARROW_LEFT:
+      editorCursorMove(input);
+      break;
+
+    case CTRL_KEY('l'):
+    case '\x1b':
+      break;
+
+    default:
+      editorInsertChar(input);
+      break;
+  }
+
+  quite_times = ConchPad_QUIT_TIMES;
+  TRACE_END("dispatch");
+  profileSetPhase(phase);
+}
+
+
+/** background tasks **/
+
+// each task does a bounded slice of work and returns IDLE_* flags saying
+// whether it has more to do and whether the screen needs a repaint. Tasks run from editorReadKey whenever no input is waiting
+struct idleTask {
+  const char *name; // shown in traces
+  int (*run)();
+};
+
+struct idleTask editorIdleTasks[] = {
+  {"highlight idle", editorHighlightIdle},
+  {"time index idle", editorTimeIndexIdle},
+};
+
+// returns the IDLE_* flags of every task OR'd together
+int editorIdle() {
+  int phase = profileSetPhase(PROFILE_BACKGROUND);
+  int pending = 0;
+  unsigned int j;
+  for(j = 0; j < sizeof(editorIdleTasks) / sizeof(editorIdleTasks[0]); j++) {
+    TRACE_BEGIN(editorIdleTasks[j].name);
+    PROBE1(idle_start, editorIdleTasks[j].name);
+    int flags = editorIdleTasks[j].run();
+    PROBE2(idle_end, editorIdleTasks[j].name, flags);
+    TRACE_END(editorIdleTasks[j].name);
+    pending |= flags;
+  }
+  profileSetPhase(phase);
+  return pending;
+}
+
+/** headless **/
+
+// replay the key script against filename on a virtual screen, then report
+// timings, the final screen and a hash of the final buffer on stdout.
+// With dump set the buffer itself is written there ("-" for stdout)
+int editorHeadlessRun(const char *filename, const char *dump) {
+  long long start = editorNow();
+  if(filename) {
+    editorOpen((char *) filename);
+  }
+  long long loaded = editorNow();
+
+  while(!E.headless.quit) {
+    editorScreenRefresh();
+    editorProcessKeypress();
+  }
+  editorScreenRefresh();
+  long long done = editorNow();
+
+  int buflen;
+  char *buf = editorRowsToString(&buflen);
+  unsigned long long hash = 1469598103934665603ULL; // FNV-1a
+  int j;
+  for(j = 0; j < buflen; j++) {
+    hash = (hash ^ (unsigned char) buf[j]) * 1099511628211ULL;
+  }
+
+  long long keys = E.headless.keys;
+  printf("screen %dx%d\n", E.headless.screen.cols, E.headless.screen.rows);
+  printf("load_us %lld\n", (loaded - start) / 1000);
+  printf("run_us %lld\n", (done - loaded) / 1000);
+  printf("keys %lld\n", keys);
+  printf("us_per_key %.2f\n", keys > 0 ? (done - loaded) / 1000.0 / keys : 0.0);
+  printf("frames %lld\n", E.headless.frames);
+  printf("bytes_out %lld\n", E.headless.bytes);
+  printf("key_p50_us %.1f\n", hdrPercentile(&E.latency.key, 50) / 1000.0);
+  printf("key_p99_us %.1f\n", hdrPercentile(&E.latency.key, 99) / 1000.0);
+  printf("frame_p50_us %.1f\n", hdrPercentile(&E.latency.frame, 50) / 1000.0);
+  printf("frame_p99_us %.1f\n", hdrPercentile(&E.latency.frame, 99) / 1000.0);
+  printf("rows %d\n", E.numrows);
+  printf("buffer_bytes %d\n", buflen);
+  printf("buffer_fnv %016llx\n", hash);
+  printf("cursor %d:%d\n", E.cy + 1, E.cx + 1);
+  printf("--- screen ---\n");
+  vscreenDump(&E.headless.screen, stdout);
+
+  if(dump) {
+    FILE *fp = strcmp(dump, "-") == 0 ? stdout : fopen(dump, "w");
+    if(fp == NULL) {
+      perror(dump);
+    } else {
+      if(fp == stdout) {
+        printf("--- buffer ---\n");
+      }
+      fwrite(buf, 1, buflen, fp);
+      if(fp != stdout) {
+        fclose(fp);
+      }
+    }
+  }
+
+  ALLOC_FREE(ALLOC_IO, buf);
+  return 0;
+}
+
+/** init **/
+
+// initialize the buffer fields of the E struct [editorConfig], leaving
+// the terminal alone
+void editorInitState() {
+  E.cx = 0;
+  E.cy = 0;
+  E.rx = 0;
+  E.rowoff = 0;
+  E.coloff = 0;
+  E.numrows = 0;
+  E.rowcap = 0;
+  E.row = NULL;
+  E.textbytes = 0;
+  E.cachebytes = 0;
+  E.dirty = 0;
+  lineIndexInit(&E.lineidx);
+  bracketIndexInit(&E.bracketidx);
+  lineIndexInit(&E.foldidx);
+  E.outline.rows = NULL;
+  E.outline.count = 0;
+  E.outline.cap = 0;
+  E.folds = 0;
+  E.timeidx.times = NULL;
+  E.timeidx.rows = NULL;
+  E.timeidx.cap = 0;
+  editorTimeIndexReset();
+  E.filename = NULL;
+  E.mtime = 0;
+  E.dev = 0;
+  E.ino = 0;
+  E.syntax = NULL;
+  E.hl_frontier = 0;
+  E.match_row = -1;
+  E.match_rx = 0;
+  editorLatencyInit();
+  E.statusmsg[0] = '\0';
+  E.statusmsg_time = 0;
+}
+
+// release everything editorInitState and the file set up
+void editorFreeState() {
+  editorCloseFile();
+  ALLOC_FREE(ALLOC_IO, E.filename);
+  E.filename = NULL;
+  E.syntax = NULL;
+}
+
+void initEditor() {
+  editorInitState();
+  E.ttyin = STDIN_FILENO;
+  E.ttyout = STDOUT_FILENO;
+  if(editorBufferCount() == 0) {
+    editorBufferRegister();
+  }
+
+  if(E.headless.active) {
+    E.screenrows = E.headless.screen.rows;
+    E.screencols = E.headless.screen.cols;
+  } else if(getWindowSize(&E.screenrows, &E.screencols) == -1) {
+    die("getWindowSize");
+  }
+
+  E.screenrows -= 2;
+}
+
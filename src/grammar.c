@@ -0,0 +1,872 @@
+/*
+* grammar.c
+*
+* Runtime loaded syntax definitions: parsing, DFA construction, the on
+* disk cache of compiled tables, and the table driven row lexer.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "grammar.h"
+#include "alloc.h"
+
+/** defines **/
+
+#define GRAMMAR_MAX 64 // grammar files loaded
+#define GRAMMAR_MAX_NODES 64 // trie nodes per lexer context
+#define GRAMMAR_MAX_WORDS 4096
+#define GRAMMAR_CACHE_MAGIC "CPGRAM01" // bump when the table layout changes
+#define GRAMMAR_DEFAULT_SEPARATORS ",.()+-/*=~%<>[];{}"
+
+struct grammar *grammars[GRAMMAR_MAX];
+int ngrammars = 0;
+int grammarsLoaded = 0;
+static pthread_mutex_t grammarLock = PTHREAD_MUTEX_INITIALIZER; // loading and preparing
+
+/** hashing **/
+
+static uint64_t grammarHash(uint64_t h, const char *data, size_t len) {
+  size_t i;
+  for(i = 0; i < len; i++) {
+    h ^= (unsigned char) data[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+static char *grammarReadFile(const char *path, size_t *len) {
+  FILE *fp = fopen(path, "r");
+  if(!fp) {
+    return NULL;
+  }
+
+  size_t cap = 4096;
+  size_t n = 0;
+  char *buf = ALLOC_MALLOC(ALLOC_SYNTAX, cap);
+  size_t got;
+  while(buf && (got = fread(&buf[n], 1, cap - n - 1, fp)) > 0) {
+    n += got;
+    if(n == cap - 1) {
+      cap *= 2;
+      char *bigger = ALLOC_REALLOC(ALLOC_SYNTAX, buf, cap);
+      if(bigger == NULL) {
+        ALLOC_FREE(ALLOC_SYNTAX, buf);
+      }
+      buf = bigger;
+    }
+  }
+  fclose(fp);
+
+  if(buf) {
+    buf[n] = '\0';
+    *len = n;
+  }
+  return buf;
+}
+
+/** parsing **/
+
+static void grammarAddWord(struct grammar *g, const char *word, int type) {
+  if(g->nwords == GRAMMAR_MAX_WORDS || *word == '\0') {
+    return;
+  }
+
+  int j;
+  for(j = 0; j < g->nwords; j++) {
+    if(strcmp(g->words[j], word) == 0) {
+      return;
+    }
+  }
+
+  char **words = ALLOC_REALLOC(ALLOC_SYNTAX, g->words, sizeof(char *) * (g->nwords + 1));
+  unsigned char *types = ALLOC_REALLOC(ALLOC_SYNTAX, g->types, g->nwords + 1);
+  if(words) g->words = words;
+  if(types) g->types = types;
+  if(words == NULL || types == NULL) {
+    return;
+  }
+  g->words[g->nwords] = ALLOC_STRDUP(ALLOC_SYNTAX, word);
+  g->types[g->nwords] = type;
+  g->nwords++;
+}
+
+// a keyword file is one word per line, '|' suffix marks a type, '#' comments
+static int grammarKeywordFile(struct grammar *g, const char *name) {
+  char path[PATH_MAX];
+  const char *slash = strrchr(g->path, '/');
+  int dirlen = slash ? slash - g->path + 1 : 0;
+  snprintf(path, sizeof(path), "%.*s%s", dirlen, g->path, name);
+
+  size_t len;
+  char *data = grammarReadFile(path, &len);
+  if(data == NULL) {
+    return -1;
+  }
+  g->hash = grammarHash(g->hash, data, len);
+
+  char *save;
+  char *line;
+  for(line = strtok_r(data, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+    int n = strlen(line);
+    while(n > 0 && isspace((unsigned char) line[n - 1])) {
+      line[--n] = '\0';
+    }
+    if(n == 0 || line[0] == '#') {
+      continue;
+    }
+    if(line[n - 1] == '|') {
+      line[n - 1] = '\0';
+      grammarAddWord(g, line, KW_KEYWORD2);
+    } else {
+      grammarAddWord(g, line, KW_KEYWORD1);
+    }
+  }
+
+  ALLOC_FREE(ALLOC_SYNTAX, data);
+  return 0;
+}
+
+// one directive per line:
+//   name c                   match .c .h
+//   line_comment //          block_comment /* */
+//   escape \                 strings " '
+//   numbers yes              separators ,.()+-/*=~%<>[];{}
+//   keywords if else ...     types int char ...
+//   keyword_file c.keywords
+static struct grammar *grammarParse(const char *path) {
+  size_t len;
+  char *data = grammarReadFile(path, &len);
+  if(data == NULL) {
+    return NULL;
+  }
+
+  struct grammar *g = ALLOC_CALLOC(ALLOC_SYNTAX, 1, sizeof(struct grammar));
+  g->path = ALLOC_STRDUP(ALLOC_SYNTAX, path);
+  g->hash = grammarHash(0xcbf29ce484222325ULL, GRAMMAR_CACHE_MAGIC, 8);
+  g->hash = grammarHash(g->hash, data, len);
+  strcpy(g->separators, GRAMMAR_DEFAULT_SEPARATORS);
+
+  int nmatch = 0;
+  char *save;
+  char *line;
+  for(line = strtok_r(data, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+    char *lsave;
+    char *key = strtok_r(line, " \t\r", &lsave);
+    if(key == NULL || key[0] == '#') {
+      continue;
+    }
+
+    char *arg;
+    if(!strcmp(key, "name") && (arg = strtok_r(NULL, " \t\r", &lsave))) {
+      ALLOC_FREE(ALLOC_SYNTAX, g->name);
+      g->name = ALLOC_STRDUP(ALLOC_SYNTAX, arg);
+    } else if(!strcmp(key, "match")) {
+      while((arg = strtok_r(NULL, " \t\r", &lsave))) {
+        g->filematch = ALLOC_REALLOC(ALLOC_SYNTAX, g->filematch, sizeof(char *) * (nmatch + 2));
+        g->filematch[nmatch++] = ALLOC_STRDUP(ALLOC_SYNTAX, arg);
+        g->filematch[nmatch] = NULL;
+      }
+    } else if(!strcmp(key, "line_comment") && (arg = strtok_r(NULL, " \t\r", &lsave))) {
+      ALLOC_FREE(ALLOC_SYNTAX, g->line_comment);
+      g->line_comment = ALLOC_STRDUP(ALLOC_SYNTAX, arg);
+    } else if(!strcmp(key, "block_comment")) {
+      char *start = strtok_r(NULL, " \t\r", &lsave);
+      char *end = strtok_r(NULL, " \t\r", &lsave);
+      if(start && end) {
+        ALLOC_FREE(ALLOC_SYNTAX, g->block_start);
+        ALLOC_FREE(ALLOC_SYNTAX, g->block_end);
+        g->block_start = ALLOC_STRDUP(ALLOC_SYNTAX, start);
+        g->block_end = ALLOC_STRDUP(ALLOC_SYNTAX, end);
+      }
+    } else if(!strcmp(key, "strings")) {
+      int n = 0;
+      while((arg = strtok_r(NULL, " \t\r", &lsave)) && n < GRAMMAR_MAX_QUOTES) {
+        g->quotes[n++] = arg[0];
+      }
+      g->quotes[n] = '\0';
+    } else if(!strcmp(key, "escape") && (arg = strtok_r(NULL, " \t\r", &lsave))) {
+      g->escape = arg[0];
+    } else if(!strcmp(key, "numbers") && (arg = strtok_r(NULL, " \t\r", &lsave))) {
+      g->numbers = !strcmp(arg, "yes");
+    } else if(!strcmp(key, "separators") && (arg = strtok_r(NULL, " \t\r", &lsave))) {
+      snprintf(g->separators, sizeof(g->separators), "%s", arg);
+    } else if(!strcmp(key, "keywords") || !strcmp(key, "types")) {
+      int type = key[0] == 't' ? KW_KEYWORD2 : KW_KEYWORD1;
+      while((arg = strtok_r(NULL, " \t\r", &lsave))) {
+        grammarAddWord(g, arg, type);
+      }
+    } else if(!strcmp(key, "keyword_file") && (arg = strtok_r(NULL, " \t\r", &lsave))) {
+      if(grammarKeywordFile(g, arg) != 0) {
+        g->broken = 1;
+      }
+    }
+  }
+  ALLOC_FREE(ALLOC_SYNTAX, data);
+
+  if(g->name == NULL || g->filematch == NULL) {
+    g->broken = 1;
+  }
+  if(g->name == NULL) {
+    g->name = ALLOC_STRDUP(ALLOC_SYNTAX, "?");
+  }
+
+  g->syntax.filetype = g->name;
+  g->syntax.filematch = g->filematch;
+  g->syntax.keywords = &g->kw;
+  g->syntax.singleline_comment_start = g->line_comment;
+  g->syntax.multiline_comment_start = g->block_start;
+  g->syntax.multiline_comment_end = g->block_end;
+  g->syntax.flags = (g->numbers ? HL_HIGHLIGHT_NUMBERS : 0) |
+    (g->quotes[0] ? HL_HIGHLIGHT_STRINGS : 0);
+  g->syntax.grammar = g;
+
+  return g;
+}
+
+/** dfa construction **/
+
+// Aho-Corasick style automaton over the delimiters that end a context
+// (comment / string openers in normal text, the closer in a block comment)
+struct grammarTrie {
+  int nodes;
+  int child[GRAMMAR_MAX_NODES][256];
+  int delta[GRAMMAR_MAX_NODES][256];
+  int fail[GRAMMAR_MAX_NODES];
+  int depth[GRAMMAR_MAX_NODES];
+  int term[GRAMMAR_MAX_NODES]; // delimiter completed at this node, -1 if none
+  int state[GRAMMAR_MAX_NODES]; // DFA state of a non terminal node
+};
+
+static int grammarTrieBuild(struct grammarTrie *t, const char **delims, int ndelims) {
+  memset(t->child, -1, sizeof(t->child));
+  t->nodes = 1;
+  t->depth[0] = 0;
+  t->term[0] = -1;
+
+  int d;
+  for(d = 0; d < ndelims; d++) {
+    int u = 0;
+    const unsigned char *p = (const unsigned char *) delims[d];
+    for(; *p && t->term[u] == -1; p++) {
+      if(t->child[u][*p] == -1) {
+        if(t->nodes == GRAMMAR_MAX_NODES) {
+          return -1;
+        }
+        int v = t->nodes++;
+        t->depth[v] = t->depth[u] + 1;
+        t->term[v] = -1;
+        t->child[u][*p] = v;
+      }
+      u = t->child[u][*p];
+    }
+    if(t->term[u] == -1 && u != 0) {
+      t->term[u] = d;
+    }
+  }
+
+  // breadth first: the full transition function, falling back along the
+  // failure links for bytes without a trie edge
+  int queue[GRAMMAR_MAX_NODES];
+  int head = 0;
+  int tail = 0;
+  int c;
+  for(c = 0; c < 256; c++) {
+    int v = t->child[0][c];
+    if(v == -1) {
+      t->delta[0][c] = 0;
+    } else {
+      t->delta[0][c] = v;
+      t->fail[v] = 0;
+      queue[tail++] = v;
+    }
+  }
+  while(head < tail) {
+    int u = queue[head++];
+    for(c = 0; c < 256; c++) {
+      int v = t->child[u][c];
+      if(v == -1) {
+        t->delta[u][c] = t->delta[t->fail[u]][c];
+      } else {
+        t->delta[u][c] = v;
+        t->fail[v] = t->delta[t->fail[u]][c];
+        queue[tail++] = v;
+      }
+    }
+  }
+
+  int n = 0;
+  int u;
+  for(u = 0; u < t->nodes; u++) {
+    t->state[u] = t->term[u] == -1 ? n++ : -1;
+  }
+  return n;
+}
+
+// write one context into the tables: bytes that complete a delimiter jump
+// to its target state and recolor the rest of the delimiter, all other
+// bytes stay in the context with the context's color
+static void grammarTrieEmit(struct grammar *g, const struct grammarTrie *t, int base,
+    const int *target, const unsigned char *cls, unsigned char ctxcls, int eolstate) {
+  int u;
+  int c;
+  for(u = 0; u < t->nodes; u++) {
+    if(t->state[u] == -1) {
+      continue;
+    }
+
+    int s = base + t->state[u];
+    g->eol[s] = eolstate;
+    for(c = 0; c < 256; c++) {
+      int v = t->delta[u][c];
+      int idx = s * 256 + c;
+      if(t->term[v] != -1) {
+        g->next[idx] = target[t->term[v]];
+        g->emit[idx] = cls[t->term[v]];
+        g->back[idx] = t->depth[v] - 1;
+      } else {
+        g->next[idx] = base + t->state[v];
+        g->emit[idx] = ctxcls;
+        g->back[idx] = 0;
+      }
+    }
+  }
+}
+
+static void grammarFreeTables(struct grammar *g) {
+  ALLOC_FREE(ALLOC_SYNTAX, g->next);
+  ALLOC_FREE(ALLOC_SYNTAX, g->emit);
+  ALLOC_FREE(ALLOC_SYNTAX, g->back);
+  ALLOC_FREE(ALLOC_SYNTAX, g->eol);
+  g->next = NULL;
+  g->emit = NULL;
+  g->back = NULL;
+  g->eol = NULL;
+  kwTableFree(&g->kw);
+  ALLOC_FREE(ALLOC_SYNTAX, g->kwpool);
+  g->kwpool = NULL;
+}
+
+static void grammarFree(struct grammar *g) {
+  grammarFreeTables(g);
+  int j;
+  for(j = 0; g->filematch && g->filematch[j]; j++) {
+    ALLOC_FREE(ALLOC_SYNTAX, g->filematch[j]);
+  }
+  for(j = 0; j < g->nwords; j++) {
+    ALLOC_FREE(ALLOC_SYNTAX, g->words[j]);
+  }
+  ALLOC_FREE(ALLOC_SYNTAX, g->filematch);
+  ALLOC_FREE(ALLOC_SYNTAX, g->words);
+  ALLOC_FREE(ALLOC_SYNTAX, g->types);
+  ALLOC_FREE(ALLOC_SYNTAX, g->name);
+  ALLOC_FREE(ALLOC_SYNTAX, g->line_comment);
+  ALLOC_FREE(ALLOC_SYNTAX, g->block_start);
+  ALLOC_FREE(ALLOC_SYNTAX, g->block_end);
+  ALLOC_FREE(ALLOC_SYNTAX, g->path);
+  ALLOC_FREE(ALLOC_SYNTAX, g);
+}
+
+static int grammarAllocTables(struct grammar *g, int nstates) {
+  g->nstates = nstates;
+  g->next = ALLOC_MALLOC(ALLOC_SYNTAX, sizeof(uint16_t) * nstates * 256);
+  g->emit = ALLOC_MALLOC(ALLOC_SYNTAX, nstates * 256);
+  g->back = ALLOC_MALLOC(ALLOC_SYNTAX, nstates * 256);
+  g->eol = ALLOC_MALLOC(ALLOC_SYNTAX, sizeof(uint16_t) * nstates);
+  return g->next && g->emit && g->back && g->eol ? 0 : -1;
+}
+
+// state layout: normal text (trie nodes, root is state 0 so a fresh row
+// starts in it), line comment, block comment (trie nodes), then a string
+// state and an escape state per quote character
+static int grammarCompile(struct grammar *g) {
+  struct grammarTrie *normal = ALLOC_MALLOC(ALLOC_SYNTAX, sizeof(struct grammarTrie));
+  struct grammarTrie *block = ALLOC_MALLOC(ALLOC_SYNTAX, sizeof(struct grammarTrie));
+  if(normal == NULL || block == NULL) {
+    ALLOC_FREE(ALLOC_SYNTAX, normal);
+    ALLOC_FREE(ALLOC_SYNTAX, block);
+    return -1;
+  }
+
+  const char *delims[2 + GRAMMAR_MAX_QUOTES];
+  char quotestr[GRAMMAR_MAX_QUOTES][2];
+  int kind[2 + GRAMMAR_MAX_QUOTES]; // 0 line, 1 block, 2 + q for quotes
+  int ndelims = 0;
+  int q;
+
+  if(g->line_comment) {
+    kind[ndelims] = 0;
+    delims[ndelims++] = g->line_comment;
+  }
+  if(g->block_start) {
+    kind[ndelims] = 1;
+    delims[ndelims++] = g->block_start;
+  }
+  int nquotes = strlen(g->quotes);
+  for(q = 0; q < nquotes; q++) {
+    quotestr[q][0] = g->quotes[q];
+    quotestr[q][1] = '\0';
+    kind[ndelims] = 2 + q;
+    delims[ndelims++] = quotestr[q];
+  }
+
+  int nnormal = grammarTrieBuild(normal, delims, ndelims);
+  const char *enddelim[1] = { g->block_end ? g->block_end : "" };
+  int nblock = g->block_start ? grammarTrieBuild(block, enddelim, 1) : 0;
+  if(nnormal < 0 || nblock < 0) {
+    ALLOC_FREE(ALLOC_SYNTAX, normal);
+    ALLOC_FREE(ALLOC_SYNTAX, block);
+    return -1;
+  }
+
+  int line = nnormal;
+  int blockbase = line + 1;
+  int strbase = blockbase + nblock;
+  int nstates = strbase + nquotes * 2;
+
+  if(grammarAllocTables(g, nstates) != 0) {
+    ALLOC_FREE(ALLOC_SYNTAX, normal);
+    ALLOC_FREE(ALLOC_SYNTAX, block);
+    return -1;
+  }
+
+  int target[2 + GRAMMAR_MAX_QUOTES];
+  unsigned char cls[2 + GRAMMAR_MAX_QUOTES];
+  int d;
+  for(d = 0; d < ndelims; d++) {
+    if(kind[d] == 0) {
+      target[d] = line;
+      cls[d] = HL_COMMENT;
+    } else if(kind[d] == 1) {
+      target[d] = blockbase;
+      cls[d] = HL_MLCOMMENT;
+    } else {
+      target[d] = strbase + (kind[d] - 2) * 2;
+      cls[d] = HL_STRING;
+    }
+  }
+  grammarTrieEmit(g, normal, 0, target, cls, HL_NORMAL, 0);
+
+  int c;
+  for(c = 0; c < 256; c++) {
+    g->next[line * 256 + c] = line;
+    g->emit[line * 256 + c] = HL_COMMENT;
+    g->back[line * 256 + c] = 0;
+  }
+  g->eol[line] = 0;
+
+  if(nblock) {
+    int blocktarget[1] = { 0 };
+    unsigned char blockcls[1] = { HL_MLCOMMENT };
+    grammarTrieEmit(g, block, blockbase, blocktarget, blockcls, HL_MLCOMMENT, blockbase);
+  }
+
+  // an unterminated string ends with its row unless the row ends in the
+  // escape character, in which case it continues on the next one
+  for(q = 0; q < nquotes; q++) {
+    int s = strbase + q * 2;
+    int esc = s + 1;
+    for(c = 0; c < 256; c++) {
+      g->next[s * 256 + c] = c == (unsigned char) g->quotes[q] ? 0 :
+        (g->escape && c == (unsigned char) g->escape) ? esc : s;
+      g->emit[s * 256 + c] = HL_STRING;
+      g->back[s * 256 + c] = 0;
+      g->next[esc * 256 + c] = s;
+      g->emit[esc * 256 + c] = HL_STRING;
+      g->back[esc * 256 + c] = 0;
+    }
+    g->eol[s] = 0;
+    g->eol[esc] = s;
+  }
+
+  memset(g->sep, 0, sizeof(g->sep));
+  const char *p;
+  for(p = g->separators; *p; p++) {
+    g->sep[(unsigned char) *p] = 1;
+  }
+  for(c = 0; c < 256; c++) {
+    if(isspace(c) || c == 0) {
+      g->sep[c] = 1;
+    }
+  }
+
+  ALLOC_FREE(ALLOC_SYNTAX, normal);
+  ALLOC_FREE(ALLOC_SYNTAX, block);
+
+  return kwTableBuild(&g->kw, (const char **) g->words, g->types, g->nwords);
+}
+
+/** cache **/
+
+static int grammarCacheDir(char *buf, size_t bufsize) {
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  if(xdg && *xdg) {
+    snprintf(buf, bufsize, "%s/conchpad", xdg);
+    mkdir(xdg, 0755);
+  } else if(home && *home) {
+    char parent[PATH_MAX];
+    snprintf(parent, sizeof(parent), "%s/.cache", home);
+    mkdir(parent, 0755);
+    snprintf(buf, bufsize, "%s/.cache/conchpad", home);
+  } else {
+    return -1;
+  }
+
+  if(mkdir(buf, 0755) == -1 && errno != EEXIST) {
+    return -1;
+  }
+  return 0;
+}
+
+static int grammarCachePath(const struct grammar *g, char *buf, size_t bufsize) {
+  char dir[PATH_MAX - 32];
+  if(grammarCacheDir(dir, sizeof(dir)) != 0) {
+    return -1;
+  }
+  snprintf(buf, bufsize, "%s/%016llx.dfa", dir, (unsigned long long) g->hash);
+  return 0;
+}
+
+struct grammarCacheHeader {
+  char magic[8];
+  uint64_t hash;
+  uint32_t nstates;
+  uint32_t nslots;
+  uint32_t nbuckets;
+  uint32_t poolsize;
+};
+
+static int grammarCacheLoad(struct grammar *g) {
+  char path[PATH_MAX];
+  if(grammarCachePath(g, path, sizeof(path)) != 0) {
+    return -1;
+  }
+
+  FILE *fp = fopen(path, "rb");
+  if(!fp) {
+    return -1;
+  }
+
+  struct grammarCacheHeader h;
+  if(fread(&h, sizeof(h), 1, fp) != 1 || memcmp(h.magic, GRAMMAR_CACHE_MAGIC, 8) != 0 ||
+      h.hash != g->hash || h.nstates == 0 || h.nstates > 65535 ||
+      h.nslots > GRAMMAR_MAX_WORDS || h.poolsize > GRAMMAR_MAX_WORDS * 256 || // words are < 256 bytes
+      (h.nslots != 0 && h.nbuckets != kwBucketCount(h.nslots)) || // kwLookup divides by it
+      grammarAllocTables(g, h.nstates) != 0) {
+    fclose(fp);
+    return -1;
+  }
+
+  // the keyword table is released by kwTableFree, which uses plain libc
+  // like the rest of keywords.c (kwgen links it without alloc.c)
+  struct kwSlot *slots = malloc(sizeof(struct kwSlot) * (h.nslots ? h.nslots : 1));
+  uint16_t *disp = malloc(sizeof(uint16_t) * (h.nbuckets ? h.nbuckets : 1));
+  uint32_t *offsets = ALLOC_MALLOC(ALLOC_SYNTAX, sizeof(uint32_t) * (h.nslots ? h.nslots : 1));
+  unsigned char *lens = ALLOC_MALLOC(ALLOC_SYNTAX, h.nslots ? h.nslots : 1);
+  unsigned char *types = ALLOC_MALLOC(ALLOC_SYNTAX, h.nslots ? h.nslots : 1);
+  g->kwpool = ALLOC_MALLOC(ALLOC_SYNTAX, h.poolsize ? h.poolsize : 1);
+
+  size_t cells = (size_t) h.nstates * 256;
+  int ok = slots && disp && offsets && lens && types && g->kwpool &&
+    fread(g->next, sizeof(uint16_t), cells, fp) == cells &&
+    fread(g->emit, 1, cells, fp) == cells &&
+    fread(g->back, 1, cells, fp) == cells &&
+    fread(g->eol, sizeof(uint16_t), h.nstates, fp) == h.nstates &&
+    fread(g->sep, 1, 256, fp) == 256 &&
+    fread(disp, sizeof(uint16_t), h.nbuckets, fp) == h.nbuckets &&
+    fread(lens, 1, h.nslots, fp) == h.nslots &&
+    fread(types, 1, h.nslots, fp) == h.nslots &&
+    fread(offsets, sizeof(uint32_t), h.nslots, fp) == h.nslots &&
+    fread(g->kwpool, 1, h.poolsize, fp) == h.poolsize;
+  fclose(fp);
+
+  // never trust a state number read from disk
+  size_t j;
+  for(j = 0; ok && j < cells; j++) {
+    ok = g->next[j] < h.nstates;
+  }
+  for(j = 0; ok && j < h.nstates; j++) {
+    ok = g->eol[j] < h.nstates;
+  }
+  for(j = 0; ok && j < h.nslots; j++) {
+    ok = offsets[j] < h.poolsize && lens[j] < h.poolsize - offsets[j]; // room for the nul too
+    slots[j].word = &g->kwpool[offsets[j]];
+    slots[j].len = lens[j];
+    slots[j].type = types[j];
+  }
+
+  ALLOC_FREE(ALLOC_SYNTAX, offsets);
+  ALLOC_FREE(ALLOC_SYNTAX, lens);
+  ALLOC_FREE(ALLOC_SYNTAX, types);
+
+  if(!ok) {
+    free(slots);
+    free(disp);
+    grammarFreeTables(g);
+    return -1;
+  }
+
+  g->kw.slots = slots;
+  g->kw.disp = disp;
+  g->kw.nslots = h.nslots;
+  g->kw.nbuckets = h.nbuckets;
+  return 0;
+}
+
+// write to a temporary file and rename it into place so a concurrent
+// ConchPad never sees a half written cache entry
+static void grammarCacheStore(const struct grammar *g) {
+  char path[PATH_MAX];
+  char tmp[PATH_MAX + 32];
+  if(grammarCachePath(g, path, sizeof(path)) != 0) {
+    return;
+  }
+  snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int) getpid());
+
+  FILE *fp = fopen(tmp, "wb");
+  if(!fp) {
+    return;
+  }
+
+  struct grammarCacheHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, GRAMMAR_CACHE_MAGIC, 8);
+  h.hash = g->hash;
+  h.nstates = g->nstates;
+  h.nslots = g->kw.nslots;
+  h.nbuckets = g->kw.nbuckets;
+
+  uint32_t j;
+  for(j = 0; j < h.nslots; j++) {
+    h.poolsize += g->kw.slots[j].len + 1;
+  }
+
+  size_t cells = (size_t) g->nstates * 256;
+  int ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+    fwrite(g->next, sizeof(uint16_t), cells, fp) == cells &&
+    fwrite(g->emit, 1, cells, fp) == cells &&
+    fwrite(g->back, 1, cells, fp) == cells &&
+    fwrite(g->eol, sizeof(uint16_t), g->nstates, fp) == (size_t) g->nstates &&
+    fwrite(g->sep, 1, 256, fp) == 256 &&
+    fwrite(g->kw.disp, sizeof(uint16_t), h.nbuckets, fp) == h.nbuckets;
+
+  uint32_t offset = 0;
+  for(j = 0; ok && j < h.nslots; j++) {
+    ok = fputc(g->kw.slots[j].len, fp) != EOF;
+  }
+  for(j = 0; ok && j < h.nslots; j++) {
+    ok = fputc(g->kw.slots[j].type, fp) != EOF;
+  }
+  for(j = 0; ok && j < h.nslots; j++) {
+    ok = fwrite(&offset, sizeof(offset), 1, fp) == 1;
+    offset += g->kw.slots[j].len + 1;
+  }
+  for(j = 0; ok && j < h.nslots; j++) {
+    ok = fwrite(g->kw.slots[j].word, 1, g->kw.slots[j].len + 1, fp) == g->kw.slots[j].len + 1u;
+  }
+
+  if(fclose(fp) != 0 || !ok || rename(tmp, path) != 0) {
+    unlink(tmp);
+  }
+}
+
+static int grammarPrepare(struct grammar *g, int usecache) {
+  if(g->compiled || g->broken) {
+    return g->compiled ? 0 : -1;
+  }
+
+  if(usecache && grammarCacheLoad(g) == 0) {
+    g->compiled = 1;
+    return 0;
+  }
+
+  if(grammarCompile(g) != 0) {
+    grammarFreeTables(g);
+    g->broken = 1;
+    return -1;
+  }
+  if(usecache) {
+    grammarCacheStore(g);
+  }
+
+  g->compiled = 1;
+  return 0;
+}
+
+/** loading **/
+
+static void grammarLoadDir(const char *dir) {
+  DIR *d = opendir(dir);
+  if(d == NULL) {
+    return;
+  }
+
+  struct dirent *ent;
+  while((ent = readdir(d)) != NULL && ngrammars < GRAMMAR_MAX) {
+    int len = strlen(ent->d_name);
+    if(len <= 8 || strcmp(&ent->d_name[len - 8], ".grammar") != 0) {
+      continue;
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+    struct grammar *g = grammarParse(path);
+    if(g == NULL) {
+      continue;
+    }
+
+    // earlier directories take priority, so users can override a grammar
+    int j;
+    for(j = 0; j < ngrammars; j++) {
+      if(strcmp(grammars[j]->name, g->name) == 0) {
+        g->broken = 1;
+      }
+    }
+    grammars[ngrammars++] = g;
+  }
+
+  closedir(d);
+}
+
+static void grammarLoadAll() {
+  grammarsLoaded = 1;
+
+  const char *env = getenv("CONCHPAD_SYNTAX_DIR");
+  if(env && *env) {
+    grammarLoadDir(env);
+  }
+
+  char path[PATH_MAX];
+  const char *home = getenv("HOME");
+  if(home && *home) {
+    snprintf(path, sizeof(path), "%s/.config/conchpad/syntax", home);
+    grammarLoadDir(path);
+  }
+
+  // the syntax directory shipped next to the binary
+  ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 8);
+  if(len > 0) {
+    path[len] = '\0';
+    char *slash = strrchr(path, '/');
+    if(slash) {
+      strcpy(slash, "/syntax");
+      grammarLoadDir(path);
+    }
+  }
+}
+
+struct grammar *grammarLoadFile(const char *path, int usecache) {
+  struct grammar *g = grammarParse(path);
+  if(g && grammarPrepare(g, usecache) != 0) {
+    grammarFree(g);
+    return NULL;
+  }
+  return g;
+}
+
+struct editorSyntax *grammarSelect(const char *filename) {
+  if(filename == NULL) {
+    return NULL;
+  }
+
+  // libconchpad buffers may be opened from several threads at once
+  pthread_mutex_lock(&grammarLock);
+  if(!grammarsLoaded) {
+    grammarLoadAll();
+  }
+
+  struct editorSyntax *found = NULL;
+  const char *ext = strrchr(filename, '.');
+  int j;
+  for(j = 0; j < ngrammars && found == NULL; j++) {
+    struct grammar *g = grammars[j];
+    if(g->broken) {
+      continue;
+    }
+
+    int i;
+    for(i = 0; g->filematch[i]; i++) {
+      int is_ext = g->filematch[i][0] == '.';
+      if((is_ext && ext && !strcmp(ext, g->filematch[i])) ||
+          (!is_ext && strstr(filename, g->filematch[i]))) {
+        if(grammarPrepare(g, 1) == 0) {
+          found = &g->syntax;
+        }
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&grammarLock);
+
+  return found;
+}
+
+/** lexer **/
+
+// one table lookup per byte for comments and strings, then a pass over
+// the remaining plain words for numbers and keywords
+int grammarHighlight(const struct grammar *g, const char *text, int len,
+    unsigned char *hl, int state) {
+  if(state < 0 || state >= g->nstates) {
+    state = 0;
+  }
+
+  int i;
+  for(i = 0; i < len; i++) {
+    int idx = state * 256 + (unsigned char) text[i];
+    unsigned char cls = g->emit[idx];
+    int back = g->back[idx];
+    hl[i] = cls;
+    while(back > 0 && i - back >= 0) {
+      hl[i - back] = cls;
+      back--;
+    }
+    state = g->next[idx];
+  }
+  state = g->eol[state];
+
+  i = 0;
+  while(i < len) {
+    unsigned char c = text[i];
+    if(hl[i] != HL_NORMAL || g->sep[c]) {
+      i++;
+      continue;
+    }
+
+    int end = i;
+    if(g->numbers && isdigit(c)) {
+      while(end < len && hl[end] == HL_NORMAL &&
+          (isalnum((unsigned char) text[end]) || text[end] == '.')) {
+        end++;
+      }
+      memset(&hl[i], HL_NUMBER, end - i);
+    } else {
+      while(end < len && hl[end] == HL_NORMAL && !g->sep[(unsigned char) text[end]]) {
+        end++;
+      }
+      int kw = kwLookup(&g->kw, &text[i], end - i);
+      if(kw != KW_NONE) {
+        memset(&hl[i], kw == KW_KEYWORD2 ? HL_KEYWORD2 : HL_KEYWORD1, end - i);
+      }
+    }
+    i = end;
+  }
+
+  return state;
+}
@@ -0,0 +1,108 @@
+/*
+* hdrhist.c
+*
+* Log-linear histogram for latency and size measurements
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <string.h>
+
+#include "hdrhist.h"
+
+/** helpers **/
+
+static int hdrBucket(long long value) {
+  unsigned long long v = value < 0 ? 0 : value;
+  if(v < (1 << HDR_SUB_BITS)) {
+    return v;
+  }
+
+  // shift v so it lands in [HDR_HALF, 2 * HDR_HALF)
+  int msb = 63 - __builtin_clzll(v);
+  int shift = msb - (HDR_SUB_BITS - 1);
+  return (1 << HDR_SUB_BITS) + (shift - 1) * HDR_HALF + (int) (v >> shift) - HDR_HALF;
+}
+
+// largest value that lands in bucket i
+static long long hdrBucketTop(int i) {
+  if(i < (1 << HDR_SUB_BITS)) {
+    return i;
+  }
+
+  int shift = (i - (1 << HDR_SUB_BITS)) / HDR_HALF + 1;
+  unsigned long long sub = (i - (1 << HDR_SUB_BITS)) % HDR_HALF + HDR_HALF;
+  return (long long) (((sub + 1) << shift) - 1);
+}
+
+/** histogram **/
+
+void hdrInit(hdrHist *h) {
+  memset(h, 0, sizeof(*h));
+}
+
+void hdrRecord(hdrHist *h, long long value) {
+  if(value < 0) {
+    value = 0;
+  }
+  h->counts[hdrBucket(value)]++;
+  if(h->count == 0 || value < h->min) {
+    h->min = value;
+  }
+  if(value > h->max) {
+    h->max = value;
+  }
+  h->count++;
+  h->sum += value;
+}
+
+long long hdrPercentile(const hdrHist *h, double p) {
+  if(h->count == 0) {
+    return 0;
+  }
+
+  long long want = (long long) (p / 100.0 * h->count + 0.5);
+  if(want < 1) {
+    want = 1;
+  }
+
+  long long seen = 0;
+  int i;
+  for(i = 0; i < HDR_BUCKETS; i++) {
+    seen += h->counts[i];
+    if(seen >= want) {
+      long long top = hdrBucketTop(i);
+      return top < h->max ? top : h->max;
+    }
+  }
+  return h->max;
+}
+
+void hdrDump(const hdrHist *h, FILE *fp, const char *name, double scale) {
+  fprintf(fp, "# %s: count %lld min %.1f mean %.1f max %.1f\n", name, h->count,
+    h->min / scale, h->count ? (double) h->sum / h->count / scale : 0.0, h->max / scale);
+  fprintf(fp, "%12s %12s %10s %14s\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+
+  long long seen = 0;
+  int i;
+  for(i = 0; i < HDR_BUCKETS; i++) {
+    if(h->counts[i] == 0) {
+      continue;
+    }
+    seen += h->counts[i];
+    double pct = (double) seen / h->count;
+    long long top = hdrBucketTop(i);
+    if(top > h->max) {
+      top = h->max;
+    }
+    if(seen < h->count) {
+      fprintf(fp, "%12.3f %12.6f %10lld %14.2f\n", top / scale, pct, seen, 1.0 / (1.0 - pct));
+    } else {
+      fprintf(fp, "%12.3f %12.6f %10lld %14s\n", top / scale, pct, seen, "inf");
+    }
+  }
+  fprintf(fp, "\n");
+}
@@ -0,0 +1,221 @@
+/*
+* keyscript.c
+*
+* Keystroke script parser for headless runs
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "alloc.h"
+#include "keyscript.h"
+
+/** data **/
+
+struct keyName {
+  const char *name;
+  const char *bytes;
+};
+
+static const struct keyName key_names[] = {
+  {"enter", "\r"},
+  {"esc", "\x1b"},
+  {"tab", "\t"},
+  {"bs", "\x7f"},
+  {"del", "\x1b[3~"},
+  {"up", "\x1b[A"},
+  {"down", "\x1b[B"},
+  {"right", "\x1b[C"},
+  {"left", "\x1b[D"},
+  {"home", "\x1b[H"},
+  {"end", "\x1b[F"},
+  {"pgup", "\x1b[5~"},
+  {"pgdn", "\x1b[6~"},
+  {NULL, NULL}
+};
+
+/** helpers **/
+
+struct keyBuf {
+  char *b;
+  size_t len;
+  size_t cap;
+};
+
+static int keyBufAppend(struct keyBuf *kb, const char *s, size_t n) {
+  if(kb->len + n > kb->cap) {
+    size_t cap = kb->cap ? kb->cap : 256;
+    while(cap < kb->len + n) {
+      cap *= 2;
+    }
+    char *b = ALLOC_REALLOC(ALLOC_UI, kb->b, cap);
+    if(b == NULL) {
+      return -1;
+    }
+    kb->b = b;
+    kb->cap = cap;
+  }
+  memcpy(&kb->b[kb->len], s, n);
+  kb->len += n;
+  return 0;
+}
+
+static int hexval(int c) {
+  if(c >= '0' && c <= '9') return c - '0';
+  if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// bytes for the key named by name[0..n), written to out. Returns the
+// byte count or -1 if the name is unknown
+static int keyScriptNamed(const char *name, size_t n, char *out) {
+  if(n == 3 && (name[0] == 'C' || name[0] == 'c') && name[1] == '-') {
+    int c = toupper((unsigned char) name[2]);
+    if((c >= 'A' && c <= 'Z') || strchr("@[\\]^_", c)) {
+      out[0] = c & 0x1f;
+      return 1;
+    }
+    return -1;
+  }
+
+  const struct keyName *k;
+  for(k = key_names; k->name; k++) {
+    if(strlen(k->name) == n && strncmp(k->name, name, n) == 0) {
+      memcpy(out, k->bytes, strlen(k->bytes));
+      return strlen(k->bytes);
+    }
+  }
+  return -1;
+}
+
+/** key scripts **/
+
+int keyScriptParse(const char *script, size_t len, char **out, size_t *outlen,
+    char *err, size_t errcap) {
+  struct keyBuf kb = {NULL, 0, 0};
+  size_t i = 0;
+  int line = 1;
+
+  while(i < len) {
+    char c = script[i];
+    char bytes[8];
+    int n = 1;
+    long repeat = 1;
+    bytes[0] = c;
+
+    if(c == '\n') {
+      line++;
+      i++;
+      continue;
+    }
+
+    if(c == '\\' && i + 1 < len) {
+      char e = script[i + 1];
+      i += 2;
+      switch(e) {
+        case 'r': bytes[0] = '\r'; break;
+        case 't': bytes[0] = '\t'; break;
+        case 'e': bytes[0] = '\x1b'; break;
+        case 'x':
+          if(i + 1 < len && hexval(script[i]) >= 0 && hexval(script[i + 1]) >= 0) {
+            bytes[0] = hexval(script[i]) * 16 + hexval(script[i + 1]);
+            i += 2;
+            break;
+          }
+          snprintf(err, errcap, "line %d: bad \\x escape", line);
+          ALLOC_FREE(ALLOC_UI, kb.b);
+          return -1;
+        default: bytes[0] = e; break;
+      }
+    } else if(c == '<') {
+      const char *close = memchr(&script[i], '>', len - i);
+      const char *name = &script[i + 1];
+      size_t namelen = close ? (size_t) (close - name) : 0;
+      const char *star = close ? memchr(name, '*', namelen) : NULL;
+      if(star) {
+        repeat = strtol(star + 1, NULL, 10);
+        namelen = star - name;
+      }
+
+      n = close ? keyScriptNamed(name, namelen, bytes) : -1;
+      if(n < 0 || repeat < 0) {
+        snprintf(err, errcap, "line %d: unknown key <%.*s>", line,
+          close ? (int) (close - name) : 0, name);
+        ALLOC_FREE(ALLOC_UI, kb.b);
+        return -1;
+      }
+      i = close - script + 1;
+    } else {
+      i++;
+    }
+
+    while(repeat-- > 0) {
+      if(keyBufAppend(&kb, bytes, n) == -1) {
+        snprintf(err, errcap, "out of memory");
+        ALLOC_FREE(ALLOC_UI, kb.b);
+        return -1;
+      }
+    }
+  }
+
+  *out = kb.b;
+  *outlen = kb.len;
+  return 0;
+}
+
+int keyScriptLoad(const char *path, char **out, size_t *outlen, char *err, size_t errcap) {
+  FILE *fp = fopen(path, "r");
+  if(fp == NULL) {
+    snprintf(err, errcap, "%s: can't open", path);
+    return -1;
+  }
+
+  struct keyBuf kb = {NULL, 0, 0};
+  char chunk[4096];
+  size_t n;
+  while((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+    if(keyBufAppend(&kb, chunk, n) == -1) {
+      fclose(fp);
+      ALLOC_FREE(ALLOC_UI, kb.b);
+      snprintf(err, errcap, "out of memory");
+      return -1;
+    }
+  }
+  fclose(fp);
+
+  int ret = keyScriptParse(kb.b ? kb.b : "", kb.len, out, outlen, err, errcap);
+  ALLOC_FREE(ALLOC_UI, kb.b);
+  return ret;
+}
+
+size_t keyScriptNext(const char *buf, size_t len) {
+  if(len == 0) {
+    return 0;
+  }
+
+  unsigned char c = buf[0];
+  size_t n = 1;
+  if(c == '\x1b' && len > 2 && (buf[1] == '[' || buf[1] == 'O')) {
+    // CSI / SS3: parameters, then one final byte
+    n = 2;
+    while(n < len && (unsigned char) buf[n] >= 0x20 && (unsigned char) buf[n] < 0x40) {
+      n++;
+    }
+    return n < len ? n + 1 : len;
+  }
+  if(c >= 0xc0) {
+    // UTF-8 lead byte: keep its continuation bytes with it
+    while(n < len && ((unsigned char) buf[n] & 0xc0) == 0x80) {
+      n++;
+    }
+  }
+  return n;
+}
@@ -0,0 +1,181 @@
+/*
+* keywords.c
+*
+* Perfect hash construction (shared by the build time generator and by
+* grammars loaded at runtime) and the reference linear lookup. The fast
+* lookup is kwLookup in keywords.h.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "keywords.h"
+
+/** defines **/
+
+#define KW_MAX_DISP 65535
+
+/** construction **/
+
+static int kwBucketCmp(const void *a, const void *b, void *sizes) {
+  const int *sz = sizes;
+  return sz[*(const int *) b] - sz[*(const int *) a];
+}
+
+uint32_t kwBucketCount(int n) {
+  // ~2 keys per bucket keeps the displacement search short
+  return n > 1 ? (uint32_t)(n + 1) / 2 : 1;
+}
+
+// hash and displace: group keys into buckets by the low half of their hash,
+// then place buckets largest first, trying displacements until every key in
+// the bucket lands in a distinct free slot
+int kwBuildDisplacements(const uint64_t *hashes, int n, uint32_t nbuckets,
+    uint16_t *disp, int *slot) {
+  int *bucketsize = calloc(nbuckets, sizeof(int));
+  int *order = malloc(sizeof(int) * nbuckets);
+  int *trial = malloc(sizeof(int) * (n ? n : 1));
+  int result = 0;
+
+  if(bucketsize == NULL || order == NULL || trial == NULL) {
+    result = -1;
+    goto done;
+  }
+
+  uint32_t b;
+  int j;
+  for(j = 0; j < n; j++) {
+    bucketsize[(uint32_t) hashes[j] % nbuckets]++;
+    slot[j] = -1;
+  }
+  for(b = 0; b < nbuckets; b++) {
+    order[b] = b;
+    disp[b] = 0;
+  }
+  qsort_r(order, nbuckets, sizeof(int), kwBucketCmp, bucketsize);
+
+  for(b = 0; b < nbuckets && bucketsize[order[b]] > 0; b++) {
+    uint32_t bucket = order[b];
+    int d;
+    for(d = 0; d <= KW_MAX_DISP; d++) {
+      int ok = 1;
+      int placed = 0;
+      for(j = 0; j < n && ok; j++) {
+        if((uint32_t) hashes[j] % nbuckets != bucket) {
+          continue;
+        }
+        int s = kwSlotFor(hashes[j], d, n);
+        int k;
+        for(k = 0; k < placed; k++) {
+          if(trial[k] == s) {
+            ok = 0;
+          }
+        }
+        if(slot[s] != -1) {
+          ok = 0;
+        }
+        trial[placed++] = s;
+      }
+
+      if(ok) {
+        break;
+      }
+    }
+    if(d > KW_MAX_DISP) {
+      result = -1;
+      goto done;
+    }
+
+    disp[bucket] = d;
+    for(j = 0; j < n; j++) {
+      if((uint32_t) hashes[j] % nbuckets == bucket) {
+        slot[kwSlotFor(hashes[j], d, n)] = j;
+      }
+    }
+  }
+
+done:
+  free(bucketsize);
+  free(order);
+  free(trial);
+  return result;
+}
+
+int kwTableBuild(struct kwTable *t, const char **words, const unsigned char *types, int n) {
+  t->slots = NULL;
+  t->disp = NULL;
+  t->nslots = 0;
+  t->nbuckets = 0;
+  if(n == 0) {
+    return 0;
+  }
+
+  uint32_t nbuckets = kwBucketCount(n);
+  uint64_t *hashes = malloc(sizeof(uint64_t) * n);
+  int *slot = malloc(sizeof(int) * n);
+  struct kwSlot *slots = malloc(sizeof(struct kwSlot) * n);
+  uint16_t *disp = malloc(sizeof(uint16_t) * nbuckets);
+
+  int j;
+  if(hashes && slot && slots && disp) {
+    for(j = 0; j < n; j++) {
+      hashes[j] = kwHash(words[j], strlen(words[j]));
+    }
+  }
+
+  if(!hashes || !slot || !slots || !disp ||
+      kwBuildDisplacements(hashes, n, nbuckets, disp, slot) != 0) {
+    free(hashes);
+    free(slot);
+    free(slots);
+    free(disp);
+    return -1;
+  }
+
+  for(j = 0; j < n; j++) {
+    slots[j].word = words[slot[j]];
+    slots[j].len = strlen(words[slot[j]]);
+    slots[j].type = types[slot[j]];
+  }
+
+  free(hashes);
+  free(slot);
+  t->slots = slots;
+  t->disp = disp;
+  t->nslots = n;
+  t->nbuckets = nbuckets;
+  return 0;
+}
+
+void kwTableFree(struct kwTable *t) {
+  free((void *) t->slots);
+  free((void *) t->disp);
+  t->slots = NULL;
+  t->disp = NULL;
+  t->nslots = 0;
+  t->nbuckets = 0;
+}
+
+/** lookup **/
+
+int kwLookupLinear(const struct kwTable *t, const char *s, int len) {
+  if(t == NULL) {
+    return KW_NONE;
+  }
+
+  uint32_t j;
+  for(j = 0; j < t->nslots; j++) {
+    if(t->slots[j].len == len && strncmp(t->slots[j].word, s, len) == 0) {
+      return t->slots[j].type;
+    }
+  }
+
+  return KW_NONE;
+}
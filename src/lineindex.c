@@ -0,0 +1,134 @@
+/*
+* lineindex.c
+*
+* Fenwick tree over row byte lengths used for goto line / byte offset
+* and for showing the cursor's byte offset in the status bar.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "lineindex.h"
+
+/** lineindex **/
+
+void lineIndexInit(lineIndex *li) {
+  li->tree = NULL;
+  li->n = 0;
+  li->cap = 0;
+  li->valid = 0;
+  li->upto = 0;
+}
+
+void lineIndexFree(lineIndex *li) {
+  ALLOC_FREE(ALLOC_INDEX, li->tree);
+  lineIndexInit(li);
+}
+
+// fill the leaves then push each node into its parent; this is the
+// standard linear time construction instead of n calls to lineIndexAdd
+void lineIndexBuild(lineIndex *li, int n, lineIndexLenFn len, void *ctx) {
+  if(n > li->cap) {
+    int newcap = li->cap ? li->cap : 64;
+    while(newcap < n) {
+      newcap *= 2;
+    }
+
+    long long *tree = ALLOC_REALLOC(ALLOC_INDEX, li->tree, sizeof(long long) * (newcap + 1));
+    if(tree == NULL) {
+      li->valid = 0;
+      li->upto = 0;
+      return;
+    }
+    li->tree = tree;
+    li->cap = newcap;
+  }
+
+  li->n = n;
+  li->upto = n;
+  if(li->tree == NULL) {
+    li->valid = 1;
+    return;
+  }
+
+  li->tree[0] = 0;
+  int i;
+  for(i = 1; i <= n; i++) {
+    li->tree[i] = len(i - 1, ctx);
+  }
+
+  for(i = 1; i <= n; i++) {
+    int parent = i + (i & -i);
+    if(parent <= n) {
+      li->tree[parent] += li->tree[i];
+    }
+  }
+
+  li->valid = 1;
+}
+
+void lineIndexInvalidate(lineIndex *li, int i) {
+  li->valid = 0;
+  if(i < li->upto) {
+    li->upto = i;
+  }
+}
+
+void lineIndexAdd(lineIndex *li, int i, long long delta) {
+  if(i < 0 || i >= li->n) {
+    return;
+  }
+
+  for(i++; i <= li->n; i += i & -i) {
+    li->tree[i] += delta;
+  }
+}
+
+long long lineIndexPrefix(const lineIndex *li, int i) {
+  if(i > li->n) {
+    i = li->n;
+  }
+
+  long long sum = 0;
+  for(; i > 0; i -= i & -i) {
+    sum += li->tree[i];
+  }
+
+  return sum;
+}
+
+long long lineIndexTotal(const lineIndex *li) {
+  return lineIndexPrefix(li, li->n);
+}
+
+// walk down the implicit tree from the highest power of two, keeping the
+// largest prefix whose sum is still <= offset. The row after that prefix
+// is the one containing the offset.
+int lineIndexFind(const lineIndex *li, long long offset) {
+  if(li->n == 0) {
+    return -1;
+  }
+  if(offset < 0) {
+    return 0;
+  }
+
+  int step = 1;
+  while(step * 2 <= li->n) {
+    step *= 2;
+  }
+
+  int pos = 0;
+  for(; step > 0; step /= 2) {
+    if(pos + step <= li->n && li->tree[pos + step] <= offset) {
+      pos += step;
+      offset -= li->tree[pos];
+    }
+  }
+
+  return pos < li->n ? pos : li->n - 1;
+}
@@ -0,0 +1,207 @@
+/*
+* profile.c
+*
+* SIGPROF stack sampler and the folded stack writer
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <execinfo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "profile.h"
+
+/** data **/
+
+struct profileStack {
+  unsigned long long hash; // 0 for an unused slot
+  int phase;
+  int depth;
+  void *frames[PROFILE_DEPTH];
+  long long count;
+};
+
+static const char *profilePhaseNames[PROFILE_PHASES] = {
+  "other", "input", "render", "load", "save", "search", "background"
+};
+
+__thread volatile sig_atomic_t profileCurrentPhase = PROFILE_OTHER;
+
+static struct profileStack *profileStacks = NULL;
+static int profileBusy = 0; // a handler is updating the table
+static long long profileDropped = 0; // samples that found the table busy or full
+static const char *profilePath;
+
+/** sampling **/
+
+// runs on whichever thread was burning CPU. backtrace() is warmed up in
+// profileStart so it doesn't allocate here, and the table is only ever
+// touched by one handler at a time; a sample that would have to wait is
+// dropped instead
+__attribute__((noinline)) static void profileSignal(int sig) {
+  (void) sig;
+  int saved = errno;
+  void *frames[PROFILE_DEPTH + 2];
+  int depth = backtrace(frames, PROFILE_DEPTH + 2);
+  int phase = profileCurrentPhase;
+
+  // skip this handler and the signal trampoline
+  depth = depth > 2 ? depth - 2 : 0;
+  unsigned long long hash = 1469598103934665603ULL ^ phase;
+  int j;
+  for(j = 0; j < depth; j++) {
+    hash = (hash ^ (unsigned long long) (size_t) frames[j + 2]) * 1099511628211ULL;
+  }
+  hash |= 1;
+
+  if(__atomic_exchange_n(&profileBusy, 1, __ATOMIC_ACQUIRE)) {
+    __atomic_fetch_add(&profileDropped, 1, __ATOMIC_RELAXED);
+    errno = saved;
+    return;
+  }
+
+  unsigned int slot = hash & (PROFILE_STACKS - 1);
+  unsigned int probes;
+  for(probes = 0; probes < PROFILE_STACKS; probes++, slot = (slot + 1) & (PROFILE_STACKS - 1)) {
+    struct profileStack *st = &profileStacks[slot];
+    if(st->hash == 0) {
+      st->hash = hash;
+      st->phase = phase;
+      st->depth = depth;
+      memcpy(st->frames, &frames[2], sizeof(void *) * depth);
+    }
+    if(st->hash == hash) {
+      st->count++;
+      break;
+    }
+  }
+  if(probes == PROFILE_STACKS) {
+    profileDropped++;
+  }
+
+  __atomic_store_n(&profileBusy, 0, __ATOMIC_RELEASE);
+  errno = saved;
+}
+
+/** output **/
+
+// a frame for a folded stack out of a backtrace_symbols line: the
+// function name, or module+offset (for addr2line) when there is none
+static void profileFrameName(const char *symbol, char *buf, size_t bufsize) {
+  const char *open = strchr(symbol, '(');
+  const char *plus = open ? strpbrk(open, "+)") : NULL;
+  if(open && plus && plus > open + 1) {
+    snprintf(buf, bufsize, "%.*s", (int) (plus - open - 1), open + 1);
+    return;
+  }
+
+  const char *base = strrchr(symbol, '/');
+  base = base ? base + 1 : symbol;
+  const char *close = open ? strchr(open, ')') : NULL;
+  if(open && close && base < open) {
+    snprintf(buf, bufsize, "%.*s%.*s", (int) (open - base), base, (int) (close - open - 1), open + 1);
+  } else {
+    snprintf(buf, bufsize, "%s", symbol);
+  }
+
+  // ';' and ' ' separate frames and counts in the folded format
+  char *c;
+  for(c = buf; *c; c++) {
+    if(*c == ';' || *c == ' ') {
+      *c = '_';
+    }
+  }
+}
+
+int profileWrite(const char *path) {
+  struct itimerval off;
+  memset(&off, 0, sizeof(off));
+  setitimer(ITIMER_PROF, &off, NULL);
+  if(profileStacks == NULL) {
+    return -1;
+  }
+
+  // wait out a handler still running on another thread
+  while(__atomic_exchange_n(&profileBusy, 1, __ATOMIC_ACQUIRE));
+
+  FILE *fp = fopen(path, "w");
+  if(fp == NULL) {
+    return -1;
+  }
+
+  int j;
+  for(j = 0; j < PROFILE_STACKS; j++) {
+    struct profileStack *st = &profileStacks[j];
+    if(st->hash == 0) {
+      continue;
+    }
+
+    fprintf(fp, "phase:%s", profilePhaseNames[st->phase]);
+    char **symbols = backtrace_symbols(st->frames, st->depth);
+    int f;
+    for(f = st->depth - 1; f >= 0; f--) {
+      char name[160];
+      profileFrameName(symbols ? symbols[f] : "?", name, sizeof(name));
+      fprintf(fp, ";%s", name);
+    }
+    fprintf(fp, " %lld\n", st->count);
+    free(symbols);
+  }
+  if(profileDropped) {
+    fprintf(fp, "phase:other;[dropped] %lld\n", profileDropped);
+  }
+
+  return fclose(fp) == 0 ? 0 : -1;
+}
+
+static void profileAtExit() {
+  profileWrite(profilePath);
+}
+
+/** api **/
+
+int profileStart(const char *path, int hz) {
+  if(hz < 1 || hz > 100000) {
+    return -1;
+  }
+  profileStacks = calloc(PROFILE_STACKS, sizeof(struct profileStack));
+  if(profileStacks == NULL) {
+    return -1;
+  }
+
+  // the first backtrace() loads the unwinder, which must not happen
+  // inside the signal handler
+  void *warm[4];
+  backtrace(warm, 4);
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = profileSignal;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  if(sigaction(SIGPROF, &sa, NULL) == -1) {
+    return -1;
+  }
+
+  struct itimerval timer;
+  long usec = 1000000 / hz;
+  timer.it_interval.tv_sec = usec / 1000000;
+  timer.it_interval.tv_usec = usec % 1000000;
+  timer.it_value = timer.it_interval;
+  if(setitimer(ITIMER_PROF, &timer, NULL) == -1) {
+    return -1;
+  }
+
+  profilePath = path;
+  atexit(profileAtExit);
+  return 0;
+}
@@ -0,0 +1,128 @@
+/*
+* sortedseek.c
+*
+* "seek to key" for sorted files (logs, sorted dumps, dictionaries).
+* Works directly on the mmap'd file so even huge files only touch
+* O(log n) pages.
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _DEFAULT_SOURCE
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sortedseek.h"
+
+/** helpers **/
+
+// compare the line starting at pos against the key. Lines shorter than
+// the key that match as far as they go sort before it
+static int sortedSeekCompare(const char *data, size_t len, size_t pos,
+    const char *key, size_t keylen) {
+  const char *nl = memchr(&data[pos], '\n', len - pos);
+  size_t linelen = nl ? (size_t)(nl - &data[pos]) : len - pos;
+
+  size_t n = linelen < keylen ? linelen : keylen;
+  int cmp = memcmp(&data[pos], key, n);
+  if(cmp != 0) {
+    return cmp;
+  }
+
+  return linelen < keylen ? -1 : 0;
+}
+
+// first line start strictly after pos (len if there is none)
+static size_t sortedSeekNextLine(const char *data, size_t len, size_t pos) {
+  const char *nl = memchr(&data[pos], '\n', len - pos);
+  return nl ? (size_t)(nl - data) + 1 : len;
+}
+
+/** sorted seek **/
+
+// lo is always a line start that sorts before the key and hi is always a
+// line start (or len) that sorts at or after it. Probes are taken between
+// lo and probehi; when a probe resyncs to hi there is no line start in the
+// upper half of the window, so only the probe bound shrinks.
+long long sortedSeekLower(const char *data, size_t len, const char *key, size_t keylen) {
+  if(len == 0 || sortedSeekCompare(data, len, 0, key, keylen) >= 0) {
+    return 0;
+  }
+
+  size_t lo = 0;
+  size_t hi = len;
+  size_t probehi = len;
+
+  while(probehi > lo) {
+    size_t mid = lo + (probehi - lo) / 2;
+    size_t start = sortedSeekNextLine(data, len, mid);
+
+    if(start >= hi) {
+      probehi = mid;
+      continue;
+    }
+
+    if(sortedSeekCompare(data, len, start, key, keylen) < 0) {
+      lo = start;
+    } else {
+      hi = start;
+      probehi = start;
+    }
+  }
+
+  return hi;
+}
+
+int sortedSeekFile(const char *path, const char *key, size_t keylen,
+    long long *offset, char *line, size_t linecap) {
+  int fd = open(path, O_RDONLY);
+  if(fd == -1) {
+    return -1;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) == -1) {
+    close(fd);
+    return -1;
+  }
+
+  if(st.st_size == 0) {
+    close(fd);
+    *offset = 0;
+    if(linecap > 0) {
+      line[0] = '\0';
+    }
+    return 0;
+  }
+
+  char *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED) {
+    return -1;
+  }
+
+  // probes are scattered all over the file, don't let the kernel read ahead
+  madvise(data, st.st_size, MADV_RANDOM);
+
+  *offset = sortedSeekLower(data, st.st_size, key, keylen);
+
+  if(linecap > 0) {
+    size_t n = 0;
+    while(*offset + n < (size_t)st.st_size && n < keylen && n < linecap - 1
+        && data[*offset + n] != '\n') {
+      line[n] = data[*offset + n];
+      n++;
+    }
+    line[n] = '\0';
+  }
+
+  munmap(data, st.st_size);
+  return 0;
+}
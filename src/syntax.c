@@ -0,0 +1,363 @@
+/*
+* syntax.c
+*
+* Syntax highlighting database and row lexer
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "syntax.h"
+#include "grammar.h"
+
+/** filetypes **/
+
+// built in fallbacks for when no grammar files are installed (grammars
+// loaded from syntax/<lang>.grammar take priority). Their keyword lists
+// live in syntax/<lang>.keywords and are compiled into perfect hash
+// tables at build time (see tools/kwgen.c)
+char *C_HL_extensions[] = { ".c", ".h", ".cpp", ".hpp", ".cc", NULL };
+char *PY_HL_extensions[] = { ".py", NULL };
+
+struct editorSyntax HLDB[] = {
+  {
+    "c",
+    C_HL_extensions,
+    &kw_c,
+    "//", "/*", "*/",
+    HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS,
+    NULL
+  },
+  {
+    "python",
+    PY_HL_extensions,
+    &kw_python,
+    "#", NULL, NULL,
+    HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS,
+    NULL
+  },
+};
+
+#define HLDB_ENTRIES (sizeof(HLDB) / sizeof(HLDB[0]))
+
+/** syntax **/
+
+struct editorSyntax *syntaxSelect(const char *filename) {
+  if(filename == NULL) {
+    return NULL;
+  }
+
+  struct editorSyntax *loaded = grammarSelect(filename);
+  if(loaded) {
+    return loaded;
+  }
+
+  char *ext = strrchr(filename, '.');
+
+  unsigned int j;
+  for(j = 0; j < HLDB_ENTRIES; j++) {
+    struct editorSyntax *s = &HLDB[j];
+    unsigned int i = 0;
+    while(s->filematch[i]) {
+      int is_ext = (s->filematch[i][0] == '.');
+      if((is_ext && ext && !strcmp(ext, s->filematch[i])) ||
+          (!is_ext && strstr(filename, s->filematch[i]))) {
+        return s;
+      }
+      i++;
+    }
+  }
+
+  return NULL;
+}
+
+static int is_separator(int c) {
+  return isspace(c) || c == '\0' || strchr(",.()+-/*=~%<>[];{}", c) != NULL;
+}
+
+int syntaxHighlight(const struct editorSyntax *syntax, const char *text, int len,
+    unsigned char *hl, int state) {
+  memset(hl, HL_NORMAL, len);
+
+  if(syntax == NULL) {
+    return SYN_STATE_NORMAL;
+  }
+  if(syntax->grammar) {
+    return grammarHighlight(syntax->grammar, text, len, hl, state);
+  }
+
+  char *scs = syntax->singleline_comment_start;
+  char *mcs = syntax->multiline_comment_start;
+  char *mce = syntax->multiline_comment_end;
+
+  int scs_len = scs ? strlen(scs) : 0;
+  int mcs_len = mcs ? strlen(mcs) : 0;
+  int mce_len = mce ? strlen(mce) : 0;
+
+  int prev_sep = 1;
+  int in_string = (state & SYN_STATE_STRING) ? (state & 0xff) : 0;
+  int in_comment = (state == SYN_STATE_COMMENT);
+
+  int i = 0;
+  while(i < len) {
+    char c = text[i];
+    unsigned char prev_hl = (i > 0) ? hl[i - 1] : HL_NORMAL;
+
+    if(scs_len && !in_string && !in_comment) {
+      if(len - i >= scs_len && !strncmp(&text[i], scs, scs_len)) {
+        memset(&hl[i], HL_COMMENT, len - i);
+        break;
+      }
+    }
+
+    if(mcs_len && mce_len && !in_string) {
+      if(in_comment) {
+        hl[i] = HL_MLCOMMENT;
+        if(len - i >= mce_len && !strncmp(&text[i], mce, mce_len)) {
+          memset(&hl[i], HL_MLCOMMENT, mce_len);
+          i += mce_len;
+          in_comment = 0;
+          prev_sep = 1;
+          continue;
+        } else {
+          i++;
+          continue;
+        }
+      } else if(len - i >= mcs_len && !strncmp(&text[i], mcs, mcs_len)) {
+        memset(&hl[i], HL_MLCOMMENT, mcs_len);
+        i += mcs_len;
+        in_comment = 1;
+        continue;
+      }
+    }
+
+    if(syntax->flags & HL_HIGHLIGHT_STRINGS) {
+      if(in_string) {
+        hl[i] = HL_STRING;
+        if(c == '\\' && i + 1 < len) {
+          hl[i + 1] = HL_STRING;
+          i += 2;
+          continue;
+        }
+        if(c == in_string) {
+          in_string = 0;
+        }
+        i++;
+        prev_sep = 1;
+        continue;
+      } else if(c == '"' || c == '\'') {
+        in_string = c;
+        hl[i] = HL_STRING;
+        i++;
+        continue;
+      }
+    }
+
+    if(syntax->flags & HL_HIGHLIGHT_NUMBERS) {
+      if((isdigit((unsigned char) c) && (prev_sep || prev_hl == HL_NUMBER)) ||
+          (c == '.' && prev_hl == HL_NUMBER)) {
+        hl[i] = HL_NUMBER;
+        i++;
+        prev_sep = 0;
+        continue;
+      }
+    }
+
+    if(prev_sep) {
+      int end = i;
+      while(end < len && !is_separator(text[end])) {
+        end++;
+      }
+
+      int kw = kwLookup(syntax->keywords, &text[i], end - i);
+      if(kw != KW_NONE) {
+        memset(&hl[i], kw == KW_KEYWORD2 ? HL_KEYWORD2 : HL_KEYWORD1, end - i);
+        i = end;
+        prev_sep = 0;
+        continue;
+      }
+    }
+
+    prev_sep = is_separator(c);
+    i++;
+  }
+
+  if(in_comment) {
+    return SYN_STATE_COMMENT;
+  }
+
+  // a string only carries over to the next row when the row ends in a
+  // line continuation, otherwise it is unterminated and ends here
+  if(in_string && len > 0 && text[len - 1] == '\\') {
+    return SYN_STATE_STRING | in_string;
+  }
+
+  return SYN_STATE_NORMAL;
+}
+
+/** symbols **/
+
+static int is_ident(int c) {
+  return isalnum(c) || c == '_';
+}
+
+static int is_code(const unsigned char *hl, int i) {
+  return hl[i] != HL_STRING && hl[i] != HL_COMMENT && hl[i] != HL_MLCOMMENT;
+}
+
+// next identifier at or after *i outside strings / comments. Returns its
+// offset and length, or -1 once the row runs out
+static int next_word(const char *text, int len, const unsigned char *hl, int *i, int *wlen) {
+  while(*i < len && !(is_ident((unsigned char) text[*i]) && is_code(hl, *i))) {
+    (*i)++;
+  }
+  if(*i >= len) {
+    return -1;
+  }
+
+  int start = *i;
+  while(*i < len && is_ident((unsigned char) text[*i])) {
+    (*i)++;
+  }
+  *wlen = *i - start;
+  return start;
+}
+
+static int word_is(const char *text, int start, int wlen, const char *word) {
+  return (int) strlen(word) == wlen && strncmp(&text[start], word, wlen) == 0;
+}
+
+int syntaxSymbol(const char *text, int len, const unsigned char *hl, int state,
+    int *namelen, int *kind) {
+  if(state != SYN_STATE_NORMAL || len == 0) {
+    return -1;
+  }
+
+  int indent = 0;
+  while(indent < len && isspace((unsigned char) text[indent])) {
+    indent++;
+  }
+  if(indent == len) {
+    return -1;
+  }
+
+  // this codebase's own "/** section **/" markers
+  if(!is_code(hl, indent) && len - indent > 6 && strncmp(&text[indent], "/**", 3) == 0) {
+    int end = len;
+    while(end > indent && isspace((unsigned char) text[end - 1])) {
+      end--;
+    }
+    if(end - indent > 6 && strncmp(&text[end - 3], "**/", 3) == 0) {
+      int start = indent + 3;
+      end -= 3;
+      while(start < end && (text[start] == '*' || text[start] == ' ')) {
+        start++;
+      }
+      while(end > start && (text[end - 1] == '*' || text[end - 1] == ' ')) {
+        end--;
+      }
+      if(end > start) {
+        *namelen = end - start;
+        *kind = SYM_SECTION;
+        return start;
+      }
+    }
+    return -1;
+  }
+
+  // a trailing ';' means a declaration or a statement, not a definition
+  int last = len - 1;
+  while(last >= 0 && (isspace((unsigned char) text[last]) || !is_code(hl, last))) {
+    last--;
+  }
+  int declaration = last >= 0 && text[last] == ';';
+
+  int i = indent;
+  int wlen;
+  int w = next_word(text, len, hl, &i, &wlen);
+  if(w < 0) {
+    return -1;
+  }
+
+  if(indent == 0 && w == 1 && text[0] == '#' && word_is(text, w, wlen, "define")) {
+    int name = next_word(text, len, hl, &i, namelen);
+    *kind = SYM_MACRO;
+    return name;
+  }
+
+  // def / class open a definition at any depth (methods)
+  if(word_is(text, w, wlen, "def") || word_is(text, w, wlen, "class")) {
+    *kind = text[w] == 'd' ? SYM_FUNCTION : SYM_TYPE;
+    return next_word(text, len, hl, &i, namelen);
+  }
+
+  // everything else only counts at the top level, and control keywords
+  // (if, return, ...) never start a definition
+  if(indent != 0 || declaration) {
+    return -1;
+  }
+  if(hl[w] == HL_KEYWORD1 && !(word_is(text, w, wlen, "static") ||
+      word_is(text, w, wlen, "inline") || word_is(text, w, wlen, "const") ||
+      word_is(text, w, wlen, "extern") || word_is(text, w, wlen, "struct") ||
+      word_is(text, w, wlen, "union") || word_is(text, w, wlen, "enum") ||
+      word_is(text, w, wlen, "typedef"))) {
+    return -1;
+  }
+
+  // a function definition: the identifier right before the first '(' with
+  // at least one word (its return type) ahead of it
+  char *paren = memchr(text, '(', len);
+  char *assign = memchr(text, '=', len);
+  if(paren && (assign == NULL || assign > paren) && is_code(hl, paren - text)) {
+    int end = paren - text;
+    while(end > 0 && text[end - 1] == ' ') {
+      end--;
+    }
+    int start = end;
+    while(start > 0 && is_ident((unsigned char) text[start - 1])) {
+      start--;
+    }
+    if(start < end && start > w && hl[start] == HL_NORMAL) {
+      *namelen = end - start;
+      *kind = SYM_FUNCTION;
+      return start;
+    }
+    return -1;
+  }
+
+  // struct / union / enum with a body
+  int prev = w;
+  int prevlen = wlen;
+  while((w = next_word(text, len, hl, &i, &wlen)) >= 0) {
+    if(word_is(text, prev, prevlen, "struct") || word_is(text, prev, prevlen, "union") ||
+        word_is(text, prev, prevlen, "enum")) {
+      *namelen = wlen;
+      *kind = SYM_TYPE;
+      return w;
+    }
+    prev = w;
+    prevlen = wlen;
+  }
+
+  return -1;
+}
+
+/** colors **/
+
+int syntaxToColor(int hl) {
+  switch(hl) {
+    case HL_COMMENT:
+    case HL_MLCOMMENT: return 36;
+    case HL_KEYWORD1: return 33;
+    case HL_KEYWORD2: return 32;
+    case HL_STRING: return 35;
+    case HL_NUMBER: return 31;
+    default: return 37;
+  }
+}
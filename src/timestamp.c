@@ -0,0 +1,259 @@
+/*
+* timestamp.c
+*
+* Timestamp detection / parsing for log navigation
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "timestamp.h"
+
+/** defines **/
+
+#define TS_DAY 86400LL
+
+/** helpers **/
+
+static const char *tsMonths[] = {
+  "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+// days before each month in a non-leap year
+static const int tsMonthDays[] = {
+  0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+// read exactly n digits from s
+static int tsDigits(const char *s, int len, int n, int *out) {
+  if(len < n) {
+    return -1;
+  }
+
+  int v = 0;
+  int i;
+  for(i = 0; i < n; i++) {
+    if(!isdigit((unsigned char) s[i])) {
+      return -1;
+    }
+    v = v * 10 + (s[i] - '0');
+  }
+
+  *out = v;
+  return 0;
+}
+
+// HH:MM:SS -> seconds into the day
+static int tsClock(const char *s, int len, long long *t) {
+  int h, m, sec;
+  if(tsDigits(s, len, 2, &h) || len < 8 || s[2] != ':' ||
+      tsDigits(&s[3], len - 3, 2, &m) || s[5] != ':' ||
+      tsDigits(&s[6], len - 6, 2, &sec)) {
+    return -1;
+  }
+  if(h > 23 || m > 59 || sec > 60) {
+    return -1;
+  }
+
+  *t = h * 3600LL + m * 60LL + sec;
+  return 0;
+}
+
+// days since 1970-01-01 for a civil date (proleptic gregorian)
+static long long tsDaysFromCivil(int y, int m, int d) {
+  y -= m <= 2;
+  long long era = (y >= 0 ? y : y - 399) / 400;
+  long long yoe = y - era * 400;
+  long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void tsCivilFromDays(long long z, int *y, int *m, int *d) {
+  z += 719468;
+  long long era = (z >= 0 ? z : z - 146096) / 146097;
+  long long doe = z - era * 146097;
+  long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  long long mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = yoe + era * 400 + (*m <= 2);
+}
+
+/** timestamp **/
+
+int tsParse(int fmt, const char *line, int len, long long *t) {
+  if(len > 0 && line[0] == '[') {
+    line++;
+    len--;
+  }
+
+  switch(fmt) {
+    case TS_ISO: {
+      int y, mo, d;
+      long long clock;
+      if(tsDigits(line, len, 4, &y) || len < 19 || line[4] != '-' ||
+          tsDigits(&line[5], len - 5, 2, &mo) || line[7] != '-' ||
+          tsDigits(&line[8], len - 8, 2, &d) ||
+          (line[10] != ' ' && line[10] != 'T') ||
+          tsClock(&line[11], len - 11, &clock)) {
+        return -1;
+      }
+      if(mo < 1 || mo > 12 || d < 1 || d > 31) {
+        return -1;
+      }
+      *t = tsDaysFromCivil(y, mo, d) * TS_DAY + clock;
+      return 0;
+    }
+
+    case TS_SYSLOG: {
+      if(len < 15 || line[3] != ' ') {
+        return -1;
+      }
+      int mo;
+      for(mo = 0; mo < 12; mo++) {
+        if(strncmp(line, tsMonths[mo], 3) == 0) {
+          break;
+        }
+      }
+      if(mo == 12) {
+        return -1;
+      }
+
+      int d;
+      char day[2] = { line[4] == ' ' ? '0' : line[4], line[5] };
+      long long clock;
+      if(tsDigits(day, 2, 2, &d) || d < 1 || d > 31 || line[6] != ' ' ||
+          tsClock(&line[7], len - 7, &clock)) {
+        return -1;
+      }
+      *t = (tsMonthDays[mo] + d - 1) * TS_DAY + clock;
+      return 0;
+    }
+
+    case TS_CLOCK:
+      return tsClock(line, len, t);
+
+    case TS_EPOCH: {
+      // 10 digits covers 2001 - 2286, anything shorter is too ambiguous
+      int i;
+      long long v = 0;
+      for(i = 0; i < len && isdigit((unsigned char) line[i]); i++) {
+        v = v * 10 + (line[i] - '0');
+      }
+      if(i != 10) {
+        return -1;
+      }
+      *t = v;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+int tsDetect(const char *line, int len) {
+  int fmt;
+  long long t;
+  for(fmt = TS_ISO; fmt <= TS_EPOCH; fmt++) {
+    if(tsParse(fmt, line, len, &t) == 0) {
+      return fmt;
+    }
+  }
+
+  return TS_NONE;
+}
+
+const char *tsFormatName(int fmt) {
+  switch(fmt) {
+    case TS_ISO: return "iso";
+    case TS_SYSLOG: return "syslog";
+    case TS_CLOCK: return "clock";
+    case TS_EPOCH: return "epoch";
+  }
+  return "none";
+}
+
+int tsFormatTime(int fmt, long long t, char *buf, int bufsize) {
+  long long day = t / TS_DAY;
+  long long clock = t % TS_DAY;
+  if(clock < 0) {
+    clock += TS_DAY;
+    day--;
+  }
+
+  int h = clock / 3600;
+  int m = (clock / 60) % 60;
+  int s = clock % 60;
+
+  if(fmt == TS_ISO || fmt == TS_EPOCH) {
+    int y, mo, d;
+    tsCivilFromDays(day, &y, &mo, &d);
+    return snprintf(buf, bufsize, "%04d-%02d-%02d %02d:%02d:%02d", y, mo, d, h, m, s);
+  }
+
+  return snprintf(buf, bufsize, "%02d:%02d:%02d", h, m, s);
+}
+
+int tsParseQuery(int fmt, const char *query, long long ref, long long *target) {
+  int len = strlen(query);
+
+  if(strcmp(query, "+") == 0) {
+    *target = (ref / 60) * 60 + 60;
+    return 0;
+  }
+  if(strcmp(query, "-") == 0) {
+    *target = (ref / 60) * 60 - 60;
+    return 0;
+  }
+
+  if(query[0] == '+' || query[0] == '-') {
+    long long n;
+    char unit = 's';
+    if(sscanf(&query[1], "%lld%c", &n, &unit) < 1) {
+      return -1;
+    }
+
+    long long scale;
+    switch(unit) {
+      case 's': scale = 1; break;
+      case 'm': scale = 60; break;
+      case 'h': scale = 3600; break;
+      case 'd': scale = TS_DAY; break;
+      default: return -1;
+    }
+
+    *target = ref + (query[0] == '+' ? n : -n) * scale;
+    return 0;
+  }
+
+  if(tsParse(fmt, query, len, target) == 0) {
+    return 0;
+  }
+
+  // time of day, seconds optional
+  int h, m, s = 0;
+  char extra;
+  int got = sscanf(query, "%d:%d:%d%c", &h, &m, &s, &extra);
+  if(got != 2 && got != 3) {
+    return -1;
+  }
+  if(h < 0 || h > 23 || m < 0 || m > 59 || s < 0 || s > 60) {
+    return -1;
+  }
+
+  long long day = ref / TS_DAY;
+  if(ref % TS_DAY < 0) {
+    day--;
+  }
+  *target = day * TS_DAY + h * 3600LL + m * 60LL + s;
+  return 0;
+}
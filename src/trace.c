@@ -0,0 +1,174 @@
+/*
+* trace.c
+*
+* Lock-free per-thread event rings and the Chrome trace JSON writer
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/** data **/
+
+struct traceRecord {
+  const char *name;
+  long long ns;
+  int tid;
+  char phase;
+};
+
+// a ring belongs to one live thread at a time. Threads come and go (the
+// highlighter starts workers per batch), so a ring whose thread exited is
+// handed to the next new thread rather than allocating another
+struct traceRing {
+  struct traceRecord events[TRACE_RING_SIZE];
+  unsigned long head; // events ever written; published with release
+  int inuse;
+  const char *name;
+  struct traceRing *next;
+};
+
+int traceEnabled = 0;
+
+static struct traceRing *traceRings = NULL; // only ever pushed to
+static __thread struct traceRing *traceLocal = NULL;
+static __thread int traceTid = 0;
+static pthread_key_t traceKey;
+static long long traceStartNs;
+static const char *tracePath;
+
+/** helpers **/
+
+static long long traceNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// thread exit: the ring keeps its events but may be reused
+static void traceRelease(void *arg) {
+  struct traceRing *ring = arg;
+  __atomic_store_n(&ring->inuse, 0, __ATOMIC_RELEASE);
+}
+
+static struct traceRing *traceClaim() {
+  struct traceRing *ring;
+  for(ring = __atomic_load_n(&traceRings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+    int unused = 0;
+    if(__atomic_compare_exchange_n(&ring->inuse, &unused, 1, 0,
+        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      break;
+    }
+  }
+
+  if(ring == NULL) {
+    ring = calloc(1, sizeof(struct traceRing));
+    if(ring == NULL) {
+      return NULL;
+    }
+    ring->inuse = 1;
+    ring->next = __atomic_load_n(&traceRings, __ATOMIC_RELAXED);
+    while(!__atomic_compare_exchange_n(&traceRings, &ring->next, ring, 0,
+        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  }
+
+  ring->name = "thread";
+  traceTid = syscall(SYS_gettid);
+  pthread_setspecific(traceKey, ring);
+  return ring;
+}
+
+static void traceAtExit() {
+  traceFlush(tracePath);
+}
+
+/** api **/
+
+void traceStart(const char *path) {
+  pthread_key_create(&traceKey, traceRelease);
+  traceStartNs = traceNow();
+  tracePath = path;
+  traceEnabled = 1;
+  traceThreadName("main");
+  atexit(traceAtExit);
+}
+
+void traceEvent(const char *name, char phase) {
+  struct traceRing *ring = traceLocal;
+  if(ring == NULL && (ring = traceLocal = traceClaim()) == NULL) {
+    return;
+  }
+
+  // single writer, so only the head needs to be published
+  unsigned long head = ring->head;
+  struct traceRecord *ev = &ring->events[head & (TRACE_RING_SIZE - 1)];
+  ev->name = name;
+  ev->ns = traceNow();
+  ev->tid = traceTid;
+  ev->phase = phase;
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void traceThreadName(const char *name) {
+  if(!traceEnabled) {
+    return;
+  }
+  if(traceLocal == NULL && (traceLocal = traceClaim()) == NULL) {
+    return;
+  }
+  traceLocal->name = name;
+}
+
+int traceFlush(const char *path) {
+  FILE *fp = fopen(path, "w");
+  if(fp == NULL) {
+    return -1;
+  }
+
+  int pid = getpid();
+  int first = 1;
+  fprintf(fp, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+  struct traceRing *ring;
+  for(ring = __atomic_load_n(&traceRings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+    unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    unsigned long i = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    int tid = 0;
+    int depth = 0;
+
+    for(; i < head; i++) {
+      struct traceRecord *ev = &ring->events[i & (TRACE_RING_SIZE - 1)];
+      if(ev->tid != tid) {
+        tid = ev->tid;
+        depth = 0;
+        fprintf(fp, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+          "\"args\": {\"name\": \"%s\"}}", first ? "" : ",", pid, tid, ring->name);
+        first = 0;
+      }
+
+      // an end whose begin was overwritten would close an unrelated slice
+      if(ev->phase == 'E' && depth == 0) {
+        continue;
+      }
+      depth += ev->phase == 'B' ? 1 : -1;
+
+      fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"%c\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f}",
+        ev->name, ev->phase, pid, ev->tid, (ev->ns - traceStartNs) / 1000.0);
+    }
+  }
+
+  fprintf(fp, "\n]}\n");
+  return fclose(fp) == 0 ? 0 : -1;
+}
@@ -0,0 +1,218 @@
+/*
+* vscreen.c
+*
+* Virtual terminal screen used by headless runs
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "vscreen.h"
+
+/** defines **/
+
+enum vscreenState {
+  VS_GROUND = 0,
+  VS_ESCAPE, // saw ESC
+  VS_CSI // saw ESC [, collecting parameters
+};
+
+/** helpers **/
+
+static void vscreenClear(vscreen *vs, int from, int to) {
+  if(from < 0) {
+    from = 0;
+  }
+  if(to > vs->rows * vs->cols) {
+    to = vs->rows * vs->cols;
+  }
+  if(to > from) {
+    memset(&vs->chars[from], ' ', to - from);
+    memset(&vs->attrs[from], 0, sizeof(unsigned short) * (to - from));
+  }
+}
+
+// numeric parameter i of the current sequence, def when absent or 0
+static int vscreenParam(const vscreen *vs, int i, int def) {
+  const char *p = vs->params;
+  while(i-- > 0) {
+    p = strchr(p, ';');
+    if(p == NULL) {
+      return def;
+    }
+    p++;
+  }
+  int value = atoi(p[0] == '?' ? p + 1 : p);
+  return value ? value : def;
+}
+
+static void vscreenSgr(vscreen *vs) {
+  int i;
+  for(i = 0; i < vs->nparams; i++) {
+    int code = vscreenParam(vs, i, 0);
+    if(code == 0) {
+      vs->attr = 0;
+    } else if(code == 2) {
+      vs->attr |= VSCREEN_DIM;
+    } else if(code == 22) {
+      vs->attr &= ~VSCREEN_DIM;
+    } else if(code == 7) {
+      vs->attr |= VSCREEN_REVERSE;
+    } else if(code == 27) {
+      vs->attr &= ~VSCREEN_REVERSE;
+    } else if(code >= 30 && code <= 37) {
+      vs->attr = (vs->attr & 0xff00) | code;
+    } else if(code == 39) {
+      vs->attr &= 0xff00;
+    }
+  }
+}
+
+static void vscreenCsi(vscreen *vs, char final) {
+  int row = vs->cy * vs->cols;
+  switch(final) {
+    case 'H':
+      vs->cy = vscreenParam(vs, 0, 1) - 1;
+      vs->cx = vscreenParam(vs, 1, 1) - 1;
+      if(vs->cy >= vs->rows) vs->cy = vs->rows - 1;
+      if(vs->cx >= vs->cols) vs->cx = vs->cols - 1;
+      break;
+    case 'J':
+      if(vscreenParam(vs, 0, 0) == 2) {
+        vscreenClear(vs, 0, vs->rows * vs->cols);
+      } else {
+        vscreenClear(vs, row + vs->cx, vs->rows * vs->cols);
+      }
+      break;
+    case 'K':
+      vscreenClear(vs, row + vs->cx, row + vs->cols);
+      break;
+    case 'm':
+      vscreenSgr(vs);
+      break;
+    case 'h':
+    case 'l':
+      if(strcmp(vs->params, "?25") == 0) {
+        vs->cursor_visible = final == 'h';
+      }
+      break;
+    default:
+      break; // anything else (e.g. status reports) has no effect on the cells
+  }
+}
+
+/** vscreen **/
+
+int vscreenInit(vscreen *vs, int rows, int cols) {
+  vs->rows = rows;
+  vs->cols = cols;
+  vs->chars = ALLOC_MALLOC(ALLOC_RENDER, rows * cols);
+  vs->attrs = ALLOC_MALLOC(ALLOC_RENDER, sizeof(unsigned short) * rows * cols);
+  if(vs->chars == NULL || vs->attrs == NULL) {
+    vscreenFree(vs);
+    return -1;
+  }
+
+  vscreenClear(vs, 0, rows * cols);
+  vs->cy = 0;
+  vs->cx = 0;
+  vs->cursor_visible = 1;
+  vs->attr = 0;
+  vs->state = VS_GROUND;
+  vs->nparams = 0;
+  vs->params[0] = '\0';
+  return 0;
+}
+
+void vscreenFree(vscreen *vs) {
+  ALLOC_FREE(ALLOC_RENDER, vs->chars);
+  ALLOC_FREE(ALLOC_RENDER, vs->attrs);
+  vs->chars = NULL;
+  vs->attrs = NULL;
+}
+
+void vscreenWrite(vscreen *vs, const char *buf, size_t len) {
+  size_t i;
+  for(i = 0; i < len; i++) {
+    char c = buf[i];
+
+    if(vs->state == VS_ESCAPE) {
+      if(c == '[') {
+        vs->state = VS_CSI;
+        vs->params[0] = '\0';
+        vs->nparams = 0;
+      } else {
+        vs->state = VS_GROUND;
+      }
+      continue;
+    }
+
+    if(vs->state == VS_CSI) {
+      if((c >= '0' && c <= '9') || c == ';' || c == '?') {
+        size_t n = strlen(vs->params);
+        if(n < sizeof(vs->params) - 1) {
+          vs->params[n] = c;
+          vs->params[n + 1] = '\0';
+        }
+      } else {
+        const char *p;
+        vs->nparams = 1;
+        for(p = vs->params; *p; p++) {
+          vs->nparams += *p == ';';
+        }
+        vscreenCsi(vs, c);
+        vs->state = VS_GROUND;
+      }
+      continue;
+    }
+
+    if(c == '\x1b') {
+      vs->state = VS_ESCAPE;
+    } else if(c == '\r') {
+      vs->cx = 0;
+    } else if(c == '\n') {
+      if(vs->cy < vs->rows - 1) {
+        vs->cy++;
+      } else {
+        // scroll the whole screen up a line
+        memmove(vs->chars, &vs->chars[vs->cols], (vs->rows - 1) * vs->cols);
+        memmove(vs->attrs, &vs->attrs[vs->cols], sizeof(unsigned short) * (vs->rows - 1) * vs->cols);
+        vscreenClear(vs, (vs->rows - 1) * vs->cols, vs->rows * vs->cols);
+      }
+    } else if(vs->cx < vs->cols) {
+      // no autowrap: the editor never writes past the last column
+      vs->chars[vs->cy * vs->cols + vs->cx] = c;
+      vs->attrs[vs->cy * vs->cols + vs->cx] = vs->attr;
+      vs->cx++;
+    }
+  }
+}
+
+void vscreenRow(const vscreen *vs, int y, char *out) {
+  int n = vs->cols;
+  memcpy(out, &vs->chars[y * vs->cols], n);
+  while(n > 0 && out[n - 1] == ' ') {
+    n--;
+  }
+  out[n] = '\0';
+}
+
+void vscreenDump(const vscreen *vs, FILE *fp) {
+  char *line = ALLOC_MALLOC(ALLOC_RENDER, vs->cols + 1);
+  if(line == NULL) {
+    return;
+  }
+
+  int y;
+  for(y = 0; y < vs->rows; y++) {
+    vscreenRow(vs, y, line);
+    fprintf(fp, "%s\n", line);
+  }
+  ALLOC_FREE(ALLOC_RENDER, line);
+}
@@ -0,0 +1,162 @@
+/*
+* kwgen.c
+*
+* Build time generator for the keyword tables. Reads syntax/<lang>.keywords
+* files and writes a C file containing one minimal perfect hash table per
+* language. The construction itself lives in src/keywords.c so grammars
+* loaded at runtime build identical tables.
+*
+* usage: kwgen file.keywords... > keywords_gen.c
+*
+* Author: Kyle Sherman
+* Created: 2026-10-18
+*/
+
+/** includes **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "keywords.h"
+
+/** defines **/
+
+#define KWGEN_MAX_KEYWORDS 1024
+
+struct kwgenKey {
+  char word[64];
+  int len;
+  int type;
+  uint64_t hash;
+};
+
+/** generator **/
+
+static void die(const char *path, const char *msg) {
+  fprintf(stderr, "kwgen: %s: %s\n", path, msg);
+  exit(1);
+}
+
+// one keyword per line, '#' starts a comment line, trailing '|' marks a type
+static int kwgenRead(const char *path, struct kwgenKey *keys) {
+  FILE *fp = fopen(path, "r");
+  if(!fp) {
+    die(path, "cannot open");
+  }
+
+  char line[128];
+  int n = 0;
+  while(fgets(line, sizeof(line), fp)) {
+    int len = strlen(line);
+    while(len > 0 && isspace((unsigned char) line[len - 1])) {
+      line[--len] = '\0';
+    }
+    if(len == 0 || line[0] == '#') {
+      continue;
+    }
+    if(n == KWGEN_MAX_KEYWORDS) {
+      die(path, "too many keywords");
+    }
+
+    int type = KW_KEYWORD1;
+    if(line[len - 1] == '|') {
+      line[--len] = '\0';
+      type = KW_KEYWORD2;
+    }
+    if(len == 0 || len >= (int) sizeof(keys[n].word)) {
+      die(path, "bad keyword length");
+    }
+
+    int j;
+    for(j = 0; j < n; j++) {
+      if(strcmp(keys[j].word, line) == 0) {
+        die(path, "duplicate keyword");
+      }
+    }
+
+    memcpy(keys[n].word, line, len + 1);
+    keys[n].len = len;
+    keys[n].type = type;
+    keys[n].hash = kwHash(line, len);
+    n++;
+  }
+
+  fclose(fp);
+  return n;
+}
+
+// table name from the file name: syntax/c.keywords -> kw_c
+static void kwgenName(const char *path, char *name, int namecap) {
+  const char *base = strrchr(path, '/');
+  base = base ? base + 1 : path;
+
+  int n = snprintf(name, namecap, "kw_");
+  while(*base && *base != '.' && n < namecap - 1) {
+    name[n++] = isalnum((unsigned char) *base) ? *base : '_';
+    base++;
+  }
+  name[n] = '\0';
+}
+
+static void kwgenTable(const char *path) {
+  static struct kwgenKey keys[KWGEN_MAX_KEYWORDS];
+  static uint64_t hashes[KWGEN_MAX_KEYWORDS];
+  static uint16_t disp[KWGEN_MAX_KEYWORDS];
+  static int slot[KWGEN_MAX_KEYWORDS];
+  int n = kwgenRead(path, keys);
+
+  char name[64];
+  kwgenName(path, name, sizeof(name));
+
+  if(n == 0) {
+    printf("const struct kwTable %s = { NULL, NULL, 0, 0 };\n\n", name);
+    return;
+  }
+
+  int j;
+  for(j = 0; j < n; j++) {
+    hashes[j] = keys[j].hash;
+  }
+
+  uint32_t nbuckets = kwBucketCount(n);
+  if(kwBuildDisplacements(hashes, n, nbuckets, disp, slot) != 0) {
+    die(path, "no perfect hash found");
+  }
+
+  printf("/* %s: %d keywords, %u buckets */\n", path, n, nbuckets);
+  printf("static const struct kwSlot %s_slots[%d] = {\n", name, n);
+  for(j = 0; j < n; j++) {
+    struct kwgenKey *k = &keys[slot[j]];
+    printf("  { \"%s\", %d, %s },\n", k->word, k->len,
+      k->type == KW_KEYWORD2 ? "KW_KEYWORD2" : "KW_KEYWORD1");
+  }
+  printf("};\n\n");
+
+  printf("static const uint16_t %s_disp[%u] = {", name, nbuckets);
+  for(j = 0; j < (int) nbuckets; j++) {
+    printf("%s%s%d", j ? "," : "", j % 16 ? " " : "\n  ", disp[j]);
+  }
+  printf("\n};\n\n");
+
+  printf("const struct kwTable %s = { %s_slots, %s_disp, %d, %u };\n\n",
+    name, name, name, n, nbuckets);
+}
+
+int main(int argc, char *argv[]) {
+  if(argc < 2) {
+    fprintf(stderr, "usage: kwgen file.keywords... > keywords_gen.c\n");
+    return 1;
+  }
+
+  printf("/* generated by tools/kwgen.c -- do not edit */\n\n");
+  printf("#include <stddef.h>\n\n#include \"keywords.h\"\n\n");
+
+  int j;
+  for(j = 1; j < argc; j++) {
+    kwgenTable(argv[j]);
+  }
+
+  return 0;
+}